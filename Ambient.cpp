@@ -0,0 +1,108 @@
+#include "Ambient.h"
+#include "MY-HeatBed_Controller.h" // Para acessar activeSegments
+#include "TemperatureControl.h" // Para acessar cachedTemperatures e thermistorTemperature
+#include "ControlStrategy.h" // Para acessar CONTROL_AMBIENT_TEMP e o modelo
+#include "Energy.h" // Para acessar heaterWatts
+
+bool ambientCompensation = false;
+
+static float ambientFiltered = CONTROL_AMBIENT_TEMP;
+static uint8_t ambientSource = AMBIENT_FIXED;
+static float pushedTemp = 0;
+static unsigned long pushedAt = 0;
+static bool pushed = false;
+
+static bool plausible(float temp) {
+    return temp >= AMBIENT_MIN_TEMP && temp <= AMBIENT_MAX_TEMP;
+}
+
+// Called once per control tick: sensor first, then a fresh Duet value,
+// else the fixed default. The chamber drifts slowly, so the value is
+// filtered 1/4 per tick and a source change does not step the loss terms.
+void updateAmbient() {
+    float raw = CONTROL_AMBIENT_TEMP;
+    uint8_t source = AMBIENT_FIXED;
+
+    if (ambientCompensation) {
+        float sensed = AMBIENT_SENSE_PIN >= 0 ? thermistorTemperature(analogRead(AMBIENT_SENSE_PIN)) : -999.0;
+        if (sensed != -999.0 && plausible(sensed)) {
+            raw = sensed;
+            source = AMBIENT_SENSOR;
+        } else if (pushed && millis() - pushedAt <= AMBIENT_PUSH_TIMEOUT) {
+            raw = pushedTemp;
+            source = AMBIENT_DUET;
+        }
+    }
+
+    if (source != ambientSource && source == AMBIENT_FIXED && ambientCompensation) {
+        Serial.println(F("ALERT: No ambient reading. Using the default ambient."));
+    }
+    ambientSource = source;
+    ambientFiltered += (raw - ambientFiltered) * 0.25;
+}
+
+bool setAmbientTemperature(float temp) {
+    if (!plausible(temp)) return false;
+    pushedTemp = temp;
+    pushedAt = millis();
+    pushed = true;
+    return true;
+}
+
+float ambientTemperature() {
+    return ambientFiltered;
+}
+
+// Power that holds the segment where it is, per the plant model:
+// steady state needs duty = (T - ambient) / (heatRate * tau)
+float segmentLossWatts(int segment) {
+    float temp = cachedTemperatures[segment];
+    if (temp == -999.0 || modelHeatRate <= 0 || modelTau <= 0) return 0;
+    float duty = (temp - ambientFiltered) / (modelHeatRate * modelTau);
+    return max(duty, 0.0) * heaterWatts;
+}
+
+static const char ambientSourceNames[][7] PROGMEM = {"FIXED", "SENSOR", "DUET"};
+
+void printAmbientStatus() {
+    Serial.print(F("Ambient compensation: "));
+    Serial.print(ambientCompensation ? F("ON") : F("OFF"));
+    Serial.print(F(" | Temperature: "));
+    Serial.print(ambientFiltered);
+    Serial.print(F(" °C | Source: "));
+    Serial.println((const __FlashStringHelper *)ambientSourceNames[ambientSource]);
+}
+
+// LOSS W=<total> amb=<°C> seg=<w1>,...,<w16>
+void printLosses() {
+    float total = 0;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (activeSegments[i]) total += segmentLossWatts(i);
+    }
+    Serial.print(F("LOSS W="));
+    Serial.print(total, 1);
+    Serial.print(F(" amb="));
+    Serial.print(ambientFiltered, 1);
+    Serial.print(F(" seg="));
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (i > 0) Serial.print(',');
+        Serial.print(segmentLossWatts(i), 1);
+    }
+    Serial.println();
+}
+
+void saveAmbient(AmbientRecord &rec) {
+    rec.filtered = ambientFiltered;
+    rec.source = ambientSource;
+    rec.pushed = pushed;
+    rec.pushedTemp = pushedTemp;
+    rec.pushedAgeMs = millis() - pushedAt;
+}
+
+void restoreAmbient(const AmbientRecord &rec) {
+    ambientFiltered = plausible(rec.filtered) ? rec.filtered : CONTROL_AMBIENT_TEMP;
+    ambientSource = rec.source <= AMBIENT_DUET ? rec.source : (uint8_t)AMBIENT_FIXED;
+    pushed = rec.pushed && plausible(rec.pushedTemp);
+    pushedTemp = rec.pushedTemp;
+    pushedAt = millis() - rec.pushedAgeMs;
+}
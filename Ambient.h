@@ -0,0 +1,41 @@
+#ifndef AMBIENT_H
+#define AMBIENT_H
+
+#include <Arduino.h>
+
+// Compensação da temperatura ambiente / da câmara nas perdas da cama.
+// The loss feedforward, the model, keep-warm, ramps and the runaway check
+// use ambientTemperature() instead of a fixed ambient.
+
+// Analog pin of an ambient thermistor (same table as the bed sensors).
+// All 16 analog inputs of the shield are bed sensors, so it is off by
+// default; AMBIENT SET <°C> lets the Duet push the chamber temperature.
+#define AMBIENT_SENSE_PIN -1
+#define AMBIENT_PUSH_TIMEOUT 60000 // A pushed value older than this is ignored (in ms)
+#define AMBIENT_MIN_TEMP 0.0       // Plausible ambient range (in °C)
+#define AMBIENT_MAX_TEMP 80.0
+
+enum AmbientSource { AMBIENT_FIXED = 0, AMBIENT_SENSOR, AMBIENT_DUET };
+
+extern bool ambientCompensation;
+
+// Ambient filter and Duet push as STATE DUMP stores them
+struct AmbientRecord {
+    float filtered;
+    uint8_t source;
+    uint8_t pushed;
+    float pushedTemp;
+    uint32_t pushedAgeMs;
+};
+
+// Funções da compensação ambiente
+void updateAmbient();
+bool setAmbientTemperature(float temp);
+float ambientTemperature();
+float segmentLossWatts(int segment);
+void printAmbientStatus();
+void printLosses();
+void saveAmbient(AmbientRecord &rec);
+void restoreAmbient(const AmbientRecord &rec);
+
+#endif
@@ -0,0 +1,217 @@
+#include "Calibration.h"
+#include <EEPROM.h>
+#include "MY-HeatBed_Controller.h" // Para acessar pinos e faixa PWM manual
+#include "Storage.h"
+
+LinearMap pwmInMap[4] = {{0, 0}, {0, 0}, {0, 0}, {0, 0}};
+LinearMap pwmOutMap = {0, 0};
+bool pwmCalibrated = false;
+bool calibrationActive = false;
+
+// Points collected during the handshake
+static float calInDuty[4][CAL_MAX_POINTS];
+static float calInTemp[CAL_MAX_POINTS];
+static int calInCount = 0;
+static float calOutPwm[CAL_MAX_POINTS];
+static float calOutTemp[CAL_MAX_POINTS];
+static int calOutCount = 0;
+static int calOutCurrent = 0; // PWM value currently driven for the Duet to read
+
+#define CAL_MAGIC 0xCA1B
+
+struct CalibrationRecord {
+    uint16_t magic;
+    LinearMap in[4];
+    LinearMap out;
+    uint8_t checksum;
+};
+
+// Least-squares line through (x, y). Fails if fewer than two distinct x values.
+static bool fitLine(const float *x, const float *y, int n, LinearMap &map, float &maxResidual) {
+    if (n < 2) return false;
+    float sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (int i = 0; i < n; i++) {
+        sx += x[i];
+        sy += y[i];
+        sxx += x[i] * x[i];
+        sxy += x[i] * y[i];
+    }
+    float den = n * sxx - sx * sx;
+    if (fabs(den) < 1e-9) return false;
+
+    map.slope = (n * sxy - sx * sy) / den;
+    map.offset = (sy - map.slope * sx) / n;
+
+    maxResidual = 0;
+    for (int i = 0; i < n; i++) {
+        float r = fabs(map.slope * x[i] + map.offset - y[i]);
+        if (r > maxResidual) maxResidual = r;
+    }
+    return true;
+}
+
+// Duty of the signal on pin, averaged over CAL_SAMPLES periods.
+// A pin stuck at one level (no edges before PWM_TIMEOUT) reads as 0 or 1.
+float measurePwmDuty(int pin, unsigned long &highUs, unsigned long &periodUs) {
+    unsigned long sumHigh = 0, sumLow = 0;
+    int samples = 0;
+    for (int i = 0; i < CAL_SAMPLES; i++) {
+        unsigned long high = pulseIn(pin, HIGH, PWM_TIMEOUT);
+        unsigned long low = pulseIn(pin, LOW, PWM_TIMEOUT);
+        if (high == 0 || low == 0) break;
+        sumHigh += high;
+        sumLow += low;
+        samples++;
+    }
+
+    if (samples == 0) {
+        highUs = 0;
+        periodUs = 0;
+        return digitalRead(pin) == HIGH ? 1.0 : 0.0;
+    }
+
+    highUs = sumHigh / samples;
+    periodUs = (sumHigh + sumLow) / samples;
+    return (float)sumHigh / (sumHigh + sumLow);
+}
+
+void calibrationBegin() {
+    calInCount = 0;
+    calOutCount = 0;
+    calOutCurrent = 0;
+    calibrationActive = true;
+}
+
+void calibrationAbort() {
+    calibrationActive = false;
+}
+
+// The Duet is outputting the PWM it uses for setpoint temp on all four channels
+bool calibrationAddInputPoint(float temp) {
+    if (!calibrationActive || calInCount >= CAL_MAX_POINTS) return false;
+
+    for (int s = 0; s < 4; s++) {
+        unsigned long highUs, periodUs;
+        float duty = measurePwmDuty(pwmInPins[s], highUs, periodUs);
+        calInDuty[s][calInCount] = duty;
+
+        Serial.print(F("CAL IN sec="));
+        Serial.print(s + 1);
+        Serial.print(F(" temp="));
+        Serial.print(temp);
+        Serial.print(F(" high_us="));
+        Serial.print(highUs);
+        Serial.print(F(" period_us="));
+        Serial.print(periodUs);
+        Serial.print(F(" duty="));
+        Serial.println(duty, 4);
+    }
+    calInTemp[calInCount++] = temp;
+    return true;
+}
+
+// Hold a known PWM value on all outputs so the Duet can read it back
+void calibrationDriveOutput(int pwmValue) {
+    calOutCurrent = constrain(pwmValue, 0, 255);
+    for (int s = 0; s < 4; s++) {
+        analogWrite(pwmOutPins[s], calOutCurrent);
+    }
+}
+
+// The Duet reports the temperature it reads for the PWM currently driven
+bool calibrationAddOutputPoint(float temp) {
+    if (!calibrationActive || calOutCount >= CAL_MAX_POINTS) return false;
+    calOutPwm[calOutCount] = calOutCurrent;
+    calOutTemp[calOutCount] = temp;
+    calOutCount++;
+    return true;
+}
+
+bool calibrationFit() {
+    LinearMap in[4];
+    LinearMap out;
+    float residual;
+
+    for (int s = 0; s < 4; s++) {
+        if (!fitLine(calInDuty[s], calInTemp, calInCount, in[s], residual)) {
+            Serial.print(F("Error: Calibration fit failed for input of section "));
+            Serial.println(s + 1);
+            return false;
+        }
+        Serial.print(F("CAL FIT in sec="));
+        Serial.print(s + 1);
+        Serial.print(F(" max_residual="));
+        Serial.println(residual);
+    }
+
+    // Output map is fitted as temperature -> PWM value
+    if (!fitLine(calOutTemp, calOutPwm, calOutCount, out, residual)) {
+        Serial.println(F("Error: Calibration fit failed for outputs."));
+        return false;
+    }
+    Serial.print(F("CAL FIT out max_residual="));
+    Serial.println(residual);
+
+    for (int s = 0; s < 4; s++) {
+        pwmInMap[s] = in[s];
+    }
+    pwmOutMap = out;
+    pwmCalibrated = true;
+    calibrationActive = false;
+    return true;
+}
+
+// Only a fitted calibration is stored: loadCalibration() trusts the record
+bool saveCalibration() {
+    if (!pwmCalibrated) return false;
+    CalibrationRecord record;
+    record.magic = CAL_MAGIC;
+    for (int s = 0; s < 4; s++) {
+        record.in[s] = pwmInMap[s];
+    }
+    record.out = pwmOutMap;
+    record.checksum = storageChecksum(&record, sizeof(record));
+    EEPROM.put(CAL_EEPROM_ADDR, record);
+    return true;
+}
+
+bool loadCalibration() {
+    CalibrationRecord record;
+    EEPROM.get(CAL_EEPROM_ADDR, record);
+    if (record.magic != CAL_MAGIC || record.checksum != storageChecksum(&record, sizeof(record))) {
+        return false;
+    }
+    for (int s = 0; s < 4; s++) {
+        pwmInMap[s] = record.in[s];
+    }
+    pwmOutMap = record.out;
+    pwmCalibrated = true;
+    return true;
+}
+
+void printCalibration() {
+    if (!pwmCalibrated) {
+        Serial.print(F("PWM range (manual): "));
+        Serial.print(pwmMinValue);
+        Serial.print(F("-"));
+        Serial.print(pwmMaxValue);
+        Serial.print(F(" <-> "));
+        Serial.print(tempMin);
+        Serial.print(F("-"));
+        Serial.print(tempMax);
+        Serial.println(F("°C"));
+        return;
+    }
+    for (int s = 0; s < 4; s++) {
+        Serial.print(F("Sec "));
+        Serial.print(s + 1);
+        Serial.print(F(" input: temp = "));
+        Serial.print(pwmInMap[s].slope, 4);
+        Serial.print(F(" * duty + "));
+        Serial.println(pwmInMap[s].offset, 4);
+    }
+    Serial.print(F("Output: pwm = "));
+    Serial.print(pwmOutMap.slope, 4);
+    Serial.print(F(" * temp + "));
+    Serial.println(pwmOutMap.offset, 4);
+}
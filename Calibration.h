@@ -0,0 +1,38 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <Arduino.h>
+
+// Calibração automática dos mapas PWM <-> temperatura com a Duet
+
+// y = slope * x + offset
+struct LinearMap {
+    float slope;
+    float offset;
+};
+
+// Duty (0-1) measured on pwmInPins[s] -> setpoint (°C), one map per section
+extern LinearMap pwmInMap[4];
+// Temperature (°C) -> analogWrite value on pwmOutPins
+extern LinearMap pwmOutMap;
+// True once a fit (or a stored fit) replaces the SET_PWM_RANGE values
+extern bool pwmCalibrated;
+// True while the handshake owns the PWM outputs
+extern bool calibrationActive;
+
+#define CAL_MAX_POINTS 8 // Points per direction
+#define CAL_SAMPLES 8    // Pulses averaged per measurement
+
+// Funções de calibração
+void calibrationBegin();
+void calibrationAbort();
+bool calibrationAddInputPoint(float temp);
+void calibrationDriveOutput(int pwmValue);
+bool calibrationAddOutputPoint(float temp);
+bool calibrationFit();
+bool saveCalibration();
+bool loadCalibration();
+float measurePwmDuty(int pin, unsigned long &highUs, unsigned long &periodUs);
+void printCalibration();
+
+#endif
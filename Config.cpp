@@ -0,0 +1,274 @@
+#include "Config.h"
+#include <stddef.h>
+#include "MY-HeatBed_Controller.h" // Para acessar PID e faixa PWM
+#include "ControlStrategy.h"
+#include "Calibration.h"
+#include "Field.h"
+#include "Safety.h"
+#include "Storage.h"
+#include "Setpoints.h"
+#include "Mains.h"
+#include "Energy.h"
+#include "Trajectory.h"
+#include "Schedule.h"
+#include "Power.h"
+#include "Ambient.h"
+
+// Config flags
+#define CONFIG_FLAG_SURFACE 0x01
+#define CONFIG_FLAG_CALIBRATED 0x02
+#define CONFIG_FLAG_MAINS 0x04
+#define CONFIG_FLAG_RAMP 0x08
+#define CONFIG_FLAG_AMBIENT 0x10
+
+struct ControllerConfig {
+    uint8_t version;
+    uint8_t flags;
+
+    // Control
+    float pidKp, pidKi, pidKd;
+    float ffGain, modelHeatRate, modelTau, modelHorizon;
+    uint8_t strategy[4];
+    float manualDuty[4];
+    uint16_t segmentPeriod[16];
+
+    // Setpoints
+    uint8_t setpointMode;
+    uint8_t setpointSource;
+    float segmentSetpointOffset[16];
+    float rampMaxRate, bedPowerBudget;
+
+    // Duet interface and sensors
+    int16_t pwmMinValue, pwmMaxValue;
+    float tempMin, tempMax;
+    LinearMap pwmInMap[4];
+    LinearMap pwmOutMap;
+    float surfaceOffset[16];
+    float surfaceSlope[16];
+    uint32_t duetLinkTimeout;
+
+    // Power
+    float mainsNominal;
+    float heaterWatts;
+    float powerCapWatts;
+
+    uint8_t checksum;
+};
+
+#define CONFIG_CHECKSUM_SIZE (offsetof(ControllerConfig, checksum) + 1)
+
+void exportConfig() {
+    ControllerConfig cfg;
+    memset(&cfg, 0, sizeof(cfg)); // Padding too: equal settings give equal blobs
+
+    cfg.version = CONFIG_VERSION;
+    cfg.flags = (surfaceControl ? CONFIG_FLAG_SURFACE : 0) |
+                (pwmCalibrated ? CONFIG_FLAG_CALIBRATED : 0) |
+                (mainsCompensation ? CONFIG_FLAG_MAINS : 0) |
+                (rampEnabled ? CONFIG_FLAG_RAMP : 0) |
+                (ambientCompensation ? CONFIG_FLAG_AMBIENT : 0);
+    cfg.pidKp = pidKp;
+    cfg.pidKi = pidKi;
+    cfg.pidKd = pidKd;
+    cfg.ffGain = ffGain;
+    cfg.modelHeatRate = modelHeatRate;
+    cfg.modelTau = modelTau;
+    cfg.modelHorizon = modelHorizon;
+    for (int s = 0; s < 4; s++) {
+        cfg.strategy[s] = sectionStrategy[s];
+        cfg.manualDuty[s] = manualDuty[s];
+        cfg.pwmInMap[s] = pwmInMap[s];
+    }
+    for (int i = 0; i < 16; i++) {
+        cfg.segmentPeriod[i] = segmentPeriod[i];
+        cfg.segmentSetpointOffset[i] = segmentSetpointOffset[i];
+        cfg.surfaceOffset[i] = surfaceOffset[i];
+        cfg.surfaceSlope[i] = surfaceSlope[i];
+    }
+    cfg.setpointMode = setpointMode;
+    cfg.setpointSource = setpointSource;
+    cfg.rampMaxRate = rampMaxRate;
+    cfg.bedPowerBudget = bedPowerBudget;
+    cfg.pwmMinValue = pwmMinValue;
+    cfg.pwmMaxValue = pwmMaxValue;
+    cfg.tempMin = tempMin;
+    cfg.tempMax = tempMax;
+    cfg.pwmOutMap = pwmOutMap;
+    cfg.duetLinkTimeout = duetLinkTimeout;
+    cfg.mainsNominal = mainsNominalVoltage();
+    cfg.heaterWatts = heaterWatts;
+    cfg.powerCapWatts = powerCapWatts;
+    cfg.checksum = storageChecksum(&cfg, CONFIG_CHECKSUM_SIZE);
+
+    Serial.print(F("CONFIG "));
+    printHexRecord(&cfg, sizeof(cfg));
+    Serial.println();
+}
+
+static void printFloats(const float *values, int count) {
+    for (int i = 0; i < count; i++) {
+        if (i > 0) Serial.print(',');
+        Serial.print(values[i], 3);
+    }
+    Serial.println();
+}
+
+// The same settings as commands, in an order that replays cleanly:
+// SET_PWM_RANGE drops the calibration, so CAL SET comes after it
+void exportConfigScript() {
+    Serial.print(F("SET_PID "));
+    Serial.print(pidKp, 4);
+    Serial.print(' ');
+    Serial.print(pidKi, 4);
+    Serial.print(' ');
+    Serial.println(pidKd, 4);
+    Serial.print(F("SET_FF "));
+    Serial.println(ffGain, 5);
+    Serial.print(F("SET_MODEL "));
+    Serial.print(modelHeatRate, 4);
+    Serial.print(' ');
+    Serial.print(modelTau, 1);
+    Serial.print(' ');
+    Serial.println(modelHorizon, 1);
+    for (int s = 0; s < 4; s++) {
+        Serial.print(F("STRATEGY "));
+        Serial.print(s + 1);
+        Serial.print(' ');
+        Serial.print(strategyName(sectionStrategy[s]));
+        Serial.print(' ');
+        Serial.println(manualDuty[s] * 100.0, 1);
+    }
+    for (int i = 0; i < 16; i++) {
+        Serial.print(F("PERIOD "));
+        Serial.print(i + 1);
+        Serial.print(' ');
+        Serial.println(segmentPeriod[i]);
+    }
+
+    Serial.print(F("SETPOINT_OFFSETS "));
+    printFloats(segmentSetpointOffset, 16);
+    Serial.print(F("SETPOINT_MODE "));
+    Serial.println((const __FlashStringHelper *)setpointModeNames[setpointMode]);
+    Serial.print(F("SETPOINT_SOURCE "));
+    Serial.println(setpointSource == SOURCE_PWM ? F("PWM") : F("SERIAL"));
+    Serial.print(F("RAMP RATE "));
+    Serial.println(rampMaxRate, 3);
+    Serial.print(F("RAMP BUDGET "));
+    Serial.println(bedPowerBudget, 0);
+    Serial.println(rampEnabled ? F("RAMP ON") : F("RAMP OFF"));
+
+    Serial.print(F("SET_PWM_RANGE "));
+    Serial.print(pwmMinValue);
+    Serial.print(' ');
+    Serial.print(pwmMaxValue);
+    Serial.print(' ');
+    Serial.print(tempMin, 1);
+    Serial.print(' ');
+    Serial.println(tempMax, 1);
+    if (pwmCalibrated) {
+        for (int s = 0; s < 4; s++) {
+            Serial.print(F("CAL SET IN "));
+            Serial.print(s + 1);
+            Serial.print(' ');
+            Serial.print(pwmInMap[s].slope, 4);
+            Serial.print(' ');
+            Serial.println(pwmInMap[s].offset, 4);
+        }
+        Serial.print(F("CAL SET OUT "));
+        Serial.print(pwmOutMap.slope, 4);
+        Serial.print(' ');
+        Serial.println(pwmOutMap.offset, 4);
+    }
+    for (int i = 0; i < 16; i++) {
+        Serial.print(F("SURFACE "));
+        Serial.print(i + 1);
+        Serial.print(' ');
+        Serial.print(surfaceOffset[i], 3);
+        Serial.print(' ');
+        Serial.println(surfaceSlope[i], 5);
+    }
+    Serial.println(surfaceControl ? F("SURFACE ON") : F("SURFACE OFF"));
+    Serial.print(F("LINK_TIMEOUT "));
+    Serial.println(duetLinkTimeout);
+
+    Serial.print(F("MAINS NOMINAL "));
+    Serial.println(mainsNominalVoltage(), 1);
+    Serial.println(mainsCompensation ? F("MAINS ON") : F("MAINS OFF"));
+    Serial.print(F("ENERGY WATTS "));
+    Serial.println(heaterWatts, 1);
+    Serial.print(F("POWER CAP "));
+    Serial.println(powerCapWatts, 1);
+    Serial.println(ambientCompensation ? F("AMBIENT ON") : F("AMBIENT OFF"));
+}
+
+static bool configValid(const ControllerConfig &cfg) {
+    if (cfg.version != CONFIG_VERSION ||
+        cfg.checksum != storageChecksum(&cfg, CONFIG_CHECKSUM_SIZE)) return false;
+    if (cfg.setpointMode > SETPOINT_OFFSET || cfg.setpointSource > SOURCE_PWM) return false;
+    if (cfg.pwmMinValue >= cfg.pwmMaxValue || cfg.tempMin >= cfg.tempMax) return false;
+    if (cfg.rampMaxRate <= 0 || cfg.bedPowerBudget <= 0) return false;
+    if (cfg.heaterWatts <= 0 || cfg.mainsNominal <= 0 || cfg.powerCapWatts < 0) return false;
+    for (int s = 0; s < 4; s++) {
+        if (cfg.strategy[s] >= STRATEGY_COUNT) return false;
+    }
+    for (int i = 0; i < 16; i++) {
+        uint16_t period = cfg.segmentPeriod[i];
+        if (period < SCHEDULE_MINOR_MS || period > SCHEDULE_MAX_PERIOD ||
+            period % SCHEDULE_MINOR_MS != 0) return false;
+    }
+    return true;
+}
+
+// Everything is checked before anything changes; commands run between
+// control ticks, so the next tick sees the whole new configuration
+bool importConfig(Stream &port) {
+    ControllerConfig cfg;
+
+    if (!readHexRecord(port, &cfg, sizeof(cfg))) {
+        Serial.println(F("Error: Config blob has the wrong size or is not hexadecimal."));
+        return false;
+    }
+    if (!configValid(cfg)) {
+        Serial.println(F("Error: Config blob version, checksum or values invalid."));
+        return false;
+    }
+
+    pidKp = cfg.pidKp;
+    pidKi = cfg.pidKi;
+    pidKd = cfg.pidKd;
+    ffGain = cfg.ffGain;
+    modelHeatRate = cfg.modelHeatRate;
+    modelTau = cfg.modelTau;
+    modelHorizon = cfg.modelHorizon;
+    for (int s = 0; s < 4; s++) {
+        setSectionStrategy(s, cfg.strategy[s]); // Bumpless, like STRATEGY
+        manualDuty[s] = cfg.manualDuty[s];
+        pwmInMap[s] = cfg.pwmInMap[s];
+    }
+    for (int i = 0; i < 16; i++) {
+        setSegmentPeriod(i, cfg.segmentPeriod[i]);
+        segmentSetpointOffset[i] = cfg.segmentSetpointOffset[i];
+        surfaceOffset[i] = cfg.surfaceOffset[i];
+        surfaceSlope[i] = cfg.surfaceSlope[i];
+    }
+    setpointMode = cfg.setpointMode;
+    setpointSource = cfg.setpointSource;
+    rampMaxRate = cfg.rampMaxRate;
+    bedPowerBudget = cfg.bedPowerBudget;
+    setRampEnabled(cfg.flags & CONFIG_FLAG_RAMP);
+    pwmMinValue = cfg.pwmMinValue;
+    pwmMaxValue = cfg.pwmMaxValue;
+    tempMin = cfg.tempMin;
+    tempMax = cfg.tempMax;
+    pwmOutMap = cfg.pwmOutMap;
+    pwmCalibrated = cfg.flags & CONFIG_FLAG_CALIBRATED;
+    surfaceControl = cfg.flags & CONFIG_FLAG_SURFACE;
+    duetLinkTimeout = cfg.duetLinkTimeout;
+    noteDuetActivity();
+    setMainsNominal(cfg.mainsNominal);
+    mainsCompensation = cfg.flags & CONFIG_FLAG_MAINS;
+    heaterWatts = cfg.heaterWatts;
+    powerCapWatts = cfg.powerCapWatts;
+    ambientCompensation = cfg.flags & CONFIG_FLAG_AMBIENT;
+    return true;
+}
@@ -0,0 +1,16 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <Arduino.h>
+
+// Exportação/importação da configuração, para provisionar vários
+// controladores a partir do host. Unlike STATE, only settings are included:
+// no setpoints, activations, controller state or calibration in progress.
+// CONFIG <hex blob>, or one command per line with CONFIG EXPORT SCRIPT
+#define CONFIG_VERSION 3
+
+void exportConfig();
+void exportConfigScript();
+bool importConfig(Stream &port);
+
+#endif
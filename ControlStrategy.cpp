@@ -0,0 +1,243 @@
+#include "ControlStrategy.h"
+#include "MY-HeatBed_Controller.h" // Para acessar pinos, setpoints e estado do PID
+#include "TemperatureControl.h"
+#include "Shadow.h"
+#include "Field.h"
+#include "Safety.h"
+#include "Setpoints.h"
+#include "Mains.h"
+#include "KeepWarm.h"
+#include "Power.h"
+#include "Ambient.h"
+
+uint8_t sectionStrategy[4] = {STRATEGY_PID, STRATEGY_PID, STRATEGY_PID, STRATEGY_PID};
+float manualDuty[4] = {0, 0, 0, 0};
+float segmentDuty[16] = {0};
+
+float ffGain = 0.004;
+float modelHeatRate = 0.5;
+float modelTau = 600.0;
+float modelHorizon = 30.0;
+
+// Hysteresis relay state per segment
+bool hysteresisOn[16] = {false};
+
+// Cycle cost per strategy (compute call only, in µs)
+static unsigned long strategyCalls[STRATEGY_COUNT] = {0};
+static unsigned long strategyMicros[STRATEGY_COUNT] = {0};
+static unsigned long strategyMaxMicros[STRATEGY_COUNT] = {0};
+
+// ====== Strategy implementations ======
+// compute: returns a duty 0-1 for one segment
+// enter: initialises the segment state from the duty it had before the switch (bumpless)
+
+static float feedforwardDuty(float target) {
+    return constrain((target - ambientTemperature()) * ffGain, 0.0, 1.0);
+}
+
+static float hysteresisCompute(int segment, float currentTemp, float target) {
+    if (currentTemp < target - TEMP_HYSTERESIS) {
+        hysteresisOn[segment] = true;
+    } else if (currentTemp > target + TEMP_HYSTERESIS) {
+        hysteresisOn[segment] = false;
+    }
+    return hysteresisOn[segment] ? 1.0 : 0.0;
+}
+
+static void hysteresisEnter(int segment, float /*currentTemp*/, float /*target*/, float lastDuty) {
+    hysteresisOn[segment] = lastDuty > PID_OUTPUT_THRESHOLD;
+}
+
+static float pidCompute(int segment, float currentTemp, float target) {
+    return calculatePID(segment, currentTemp, target);
+}
+
+// Back-calculate the integrator so the first PID output equals lastDuty.
+// Without a valid reading (-999) there is nothing to back-calculate from:
+// start from a clean integrator instead of loading a huge one.
+static void pidPreload(int segment, float currentTemp, float target, float duty) {
+    pidLastUpdate[segment] = millis();
+    if (currentTemp == -999.0) {
+        pidIntegral[segment] = 0;
+        pidLastError[segment] = 0;
+        return;
+    }
+    float error = target - currentTemp;
+    pidIntegral[segment] = (pidKi != 0) ? (duty - pidKp * error) / pidKi : 0;
+    pidLastError[segment] = error;
+}
+
+static void pidEnter(int segment, float currentTemp, float target, float lastDuty) {
+    pidPreload(segment, currentTemp, target, lastDuty);
+}
+
+static float pidFfCompute(int segment, float currentTemp, float target) {
+    // Same PID law, with the feedforward added before the output clamp
+    float output = feedforwardDuty(target) +
+                   computePIDRaw(pidKp, pidKi, pidKd, pidIntegral[segment], pidLastError[segment],
+                                 pidLastUpdate[segment], currentTemp, target);
+    return constrain(output, 0.0, 1.0);
+}
+
+static void pidFfEnter(int segment, float currentTemp, float target, float lastDuty) {
+    pidPreload(segment, currentTemp, target, lastDuty - feedforwardDuty(target));
+}
+
+// dT/dt = duty * heatRate - (T - ambient) / tau, solved for the duty that
+// closes the error over modelHorizon seconds
+static float modelCompute(int /*segment*/, float currentTemp, float target) {
+    if (modelHeatRate <= 0 || modelTau <= 0 || modelHorizon <= 0) return 0;
+    float wantedRate = (target - currentTemp) / modelHorizon;
+    float lossRate = (currentTemp - ambientTemperature()) / modelTau;
+    return constrain((wantedRate + lossRate) / modelHeatRate, 0.0, 1.0);
+}
+
+static float manualCompute(int segment, float /*currentTemp*/, float /*target*/) {
+    return manualDuty[segment / (NUM_SEGMENTS / NUM_SECTIONS)];
+}
+
+// Stateless strategies need no handover
+static void noEnter(int /*segment*/, float /*currentTemp*/, float /*target*/, float /*lastDuty*/) {
+}
+
+struct StrategyEntry {
+    const char *name;
+    float (*compute)(int segment, float currentTemp, float target);
+    void (*enter)(int segment, float currentTemp, float target, float lastDuty);
+};
+
+// Indexed by ControlStrategy
+static const StrategyEntry strategyTable[STRATEGY_COUNT] = {
+    {"HYST",   hysteresisCompute, hysteresisEnter},
+    {"PID",    pidCompute,        pidEnter},
+    {"PIDFF",  pidFfCompute,      pidFfEnter},
+    {"MODEL",  modelCompute,      noEnter},
+    {"MANUAL", manualCompute,     noEnter}
+};
+
+// ====== Dispatch ======
+
+const char *strategyName(int strategy) {
+    if (strategy < 0 || strategy >= STRATEGY_COUNT) return "?";
+    return strategyTable[strategy].name;
+}
+
+int findStrategy(const String &name) {
+    for (int i = 0; i < STRATEGY_COUNT; i++) {
+        if (name == strategyTable[i].name) return i;
+    }
+    return -1;
+}
+
+bool setSectionStrategy(int secIndex, int strategy) {
+    if (secIndex < 0 || secIndex >= NUM_SECTIONS || strategy < 0 || strategy >= STRATEGY_COUNT) {
+        return false;
+    }
+
+    int start = secIndex * (NUM_SEGMENTS / NUM_SECTIONS);
+    int end = start + (NUM_SEGMENTS / NUM_SECTIONS) - 1;
+    float sectionDuty = 0;
+    for (int i = start; i <= end; i++) {
+        strategyTable[strategy].enter(i, cachedTemperatures[i], segmentSetpoint[i], segmentDuty[i]);
+        sectionDuty += segmentDuty[i];
+    }
+
+    // Manual mode takes over at the duty the section was running at
+    if (strategy == STRATEGY_MANUAL && sectionStrategy[secIndex] != STRATEGY_MANUAL) {
+        manualDuty[secIndex] = sectionDuty / (NUM_SEGMENTS / NUM_SECTIONS);
+    }
+
+    sectionStrategy[secIndex] = strategy;
+    return true;
+}
+
+// segmentDuty[] and the relay follow in updateRelayOutputs(), after the power cap
+void applySegmentDuty(int segment, float duty) {
+    if (thermalSafetyTriggered) duty = 0; // No relay on while latched
+    duty = compensateDuty(duty);          // Constant delivered power over mains swings
+    requestedDuty[segment] = duty;
+    updateRelayOutputs();
+}
+
+// One control step for one segment, with its section's strategy
+void controlSegment(int i) {
+    if (!activeSegments[i]) return;
+
+    int secIndex = i / (NUM_SEGMENTS / NUM_SECTIONS);
+    const StrategyEntry &strategy = strategyTable[sectionStrategy[secIndex]];
+
+    float target = segmentSetpoint[i];
+
+    float currentTemp = readTemperature(tempSensors[i]);
+    float duty = 0; // Invalid sensor: keep the segment off
+
+    if (currentTemp != -999.0) {
+        if (surfaceControl) {
+            currentTemp = surfaceTemperature(i, currentTemp);
+        }
+
+        if (keepWarmState == KEEPWARM_HOLD) {
+            duty = keepWarmDuty(i, currentTemp, target);
+        } else {
+            unsigned long startMicros = micros();
+            duty = strategy.compute(i, currentTemp, target);
+            unsigned long elapsed = micros() - startMicros;
+
+            uint8_t s = sectionStrategy[secIndex];
+            strategyCalls[s]++;
+            strategyMicros[s] += elapsed;
+            if (elapsed > strategyMaxMicros[s]) strategyMaxMicros[s] = elapsed;
+        }
+
+        // Shadow controller sees the same reading, its output is never applied
+        shadowUpdate(i, currentTemp, target, duty);
+    }
+
+    applySegmentDuty(i, duty);
+
+    // Print information to Serial
+    Serial.print(F("Segment "));
+    Serial.print(i + 1);
+    Serial.print(F(" | Current Temp: "));
+    Serial.print(currentTemp);
+    Serial.print(F("°C | Setpoint: "));
+    Serial.print(target);
+    Serial.print(F("°C | "));
+    Serial.print(strategy.name);
+    Serial.print(F(" Duty: "));
+    Serial.println(duty);
+}
+
+void controlSection(int /*secIndex*/, int start, int end) {
+    for (int i = start; i <= end; i++) {
+        controlSegment(i);
+    }
+}
+
+void printStrategies() {
+    for (int i = 0; i < NUM_SECTIONS; i++) {
+        Serial.print(F("Sec "));
+        Serial.print(i + 1);
+        Serial.print(F(" | Strategy: "));
+        Serial.print(strategyName(sectionStrategy[i]));
+        if (sectionStrategy[i] == STRATEGY_MANUAL) {
+            Serial.print(F(" ("));
+            Serial.print(manualDuty[i] * 100);
+            Serial.print(F("%)"));
+        }
+        Serial.println();
+    }
+}
+
+void printStrategyStats() {
+    for (int i = 0; i < STRATEGY_COUNT; i++) {
+        Serial.print(F("STRATEGY "));
+        Serial.print(strategyTable[i].name);
+        Serial.print(F(" calls="));
+        Serial.print(strategyCalls[i]);
+        Serial.print(F(" avg_us="));
+        Serial.print(strategyCalls[i] ? (float)strategyMicros[i] / strategyCalls[i] : 0.0);
+        Serial.print(F(" max_us="));
+        Serial.println(strategyMaxMicros[i]);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef CONTROL_STRATEGY_H
+#define CONTROL_STRATEGY_H
+
+#include <Arduino.h>
+
+// Algoritmos de controlo selecionáveis por seção
+enum ControlStrategy {
+    STRATEGY_HYSTERESIS = 0, // ON/OFF around the setpoint (TEMP_HYSTERESIS)
+    STRATEGY_PID,            // PID with the global pidKp/pidKi/pidKd gains
+    STRATEGY_PID_FF,         // PID plus steady-state loss feedforward
+    STRATEGY_MODEL,          // First-order plant model, reach setpoint over a horizon
+    STRATEGY_MANUAL,         // Fixed duty set by command
+    STRATEGY_COUNT
+};
+
+// Relays are time-proportioned: duty d keeps the relay on for d * window
+#define RELAY_WINDOW_MS 10000
+// Default ambient for the loss terms, used until an ambient reading
+// is available (see Ambient.h) (in °C)
+#define CONTROL_AMBIENT_TEMP 25.0
+
+extern uint8_t sectionStrategy[4];
+extern float manualDuty[4];
+extern float segmentDuty[16]; // Duty actually applied, after the power cap
+extern bool hysteresisOn[16];
+
+// Feedforward gain: duty per °C above ambient needed to hold temperature
+extern float ffGain;
+// Plant model: heating rate at full duty (°C/s), loss time constant (s), horizon (s)
+extern float modelHeatRate;
+extern float modelTau;
+extern float modelHorizon;
+
+// Funções de controlo
+void controlSegment(int segment);
+void controlSection(int secIndex, int start, int end);
+bool setSectionStrategy(int secIndex, int strategy);
+int findStrategy(const String &name);
+const char *strategyName(int strategy);
+void applySegmentDuty(int segment, float duty);
+void printStrategies();
+void printStrategyStats();
+
+#endif
@@ -5,41 +5,41 @@
 extern bool debugMode; // Declare as external
 
 void debugMonitor() {
-    Serial.println("=== System Monitoring ===");
+    Serial.println(F("=== System Monitoring ==="));
     for (int i = 0; i < 16; i++) {
         float temp = readTemperature(tempSensors[i]);
-        Serial.print("Segment ");
+        Serial.print(F("Segment "));
         Serial.print(i + 1);
-        Serial.print(": ");
-        Serial.print(activeSegments[i] ? "Active" : "Inactive");
-        Serial.print(" | Temp: ");
+        Serial.print(F(": "));
+        Serial.print(activeSegments[i] ? F("Active") : F("Inactive"));
+        Serial.print(F(" | Temp: "));
         Serial.print(temp);
-        Serial.println("°C");
+        Serial.println(F("°C"));
     }
 
     for (int i = 0; i < 4; i++) {
-        Serial.print("Sec ");
+        Serial.print(F("Sec "));
         Serial.print(i + 1);
-        Serial.print(" | Setpoint: ");
+        Serial.print(F(" | Setpoint: "));
         Serial.print(targetTemp[i]);
-        Serial.println("°C");
+        Serial.println(F("°C"));
     }
 
-    Serial.println("=========================");
+    Serial.println(F("========================="));
 }
 
 void printActiveSegments() {
-    Serial.print("Active segments: ");
+    Serial.print(F("Active segments: "));
     bool found = false;
     for (int i = 0; i < 16; i++) {
         if (activeSegments[i]) {
-            if (found) Serial.print(", ");
+            if (found) Serial.print(F(", "));
             Serial.print(i + 1);
             found = true;
         }
     }
     if (!found) {
-        Serial.println("None");
+        Serial.println(F("None"));
     } else {
         Serial.println();
     }
@@ -52,7 +52,3 @@ void printActiveSegmentsPeriodically() {
         printActiveSegments();
     }
 }
-
-float readTemperature(int sensorPin) {
-    // Implementation of readTemperature function
-}
@@ -0,0 +1,74 @@
+#include "Energy.h"
+#include "Pins.h" // Para acessar activeSegments
+#include "ControlStrategy.h" // Para acessar segmentDuty
+#include "Mains.h"
+#include "KeepWarm.h"
+#include "Job.h"
+
+float heaterWatts = 100.0;
+float energyWh[ENERGY_MODE_COUNT] = {0, 0, 0, 0};
+
+static const char energyModeNames[ENERGY_MODE_COUNT][9] PROGMEM = {"idle", "active", "keepwarm", "reheat"};
+
+// Power ~ V²: with compensation on, the duty was scaled by (Vnom / V)², so
+// the delivered power is the nominal power times duty / factor
+float segmentPower(int segment) {
+    float power = segmentDuty[segment] * heaterWatts;
+    if (mainsCompensation) {
+        power = power * MAINS_FACTOR_ONE / mainsFactorQ12;
+    }
+    return power;
+}
+
+// Called every minor schedule cycle (SCHEDULE_MINOR_MS), before that cycle's
+// control steps: the duties found now are charged over the whole interval
+// since the previous call, so the error is at most one minor cycle
+void accumulateEnergy() {
+    static unsigned long lastTime = 0;
+    static int lastMode = ENERGY_IDLE;
+    unsigned long now = millis();
+    float hours = (now - lastTime) / 3600000.0;
+    lastTime = now;
+
+    float power = 0;
+    bool anyActive = false;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        power += segmentPower(i);
+        if (activeSegments[i]) anyActive = true;
+    }
+
+    // The interval is charged to the mode it ran in
+    energyWh[lastMode] += power * hours;
+
+    lastMode = anyActive ? ENERGY_ACTIVE : ENERGY_IDLE;
+    if (keepWarmState == KEEPWARM_HOLD) lastMode = ENERGY_KEEPWARM;
+    else if (keepWarmState == KEEPWARM_REHEAT) lastMode = ENERGY_REHEAT;
+}
+
+float energyTotalWh() {
+    float total = 0;
+    for (int m = 0; m < ENERGY_MODE_COUNT; m++) {
+        total += energyWh[m];
+    }
+    return total;
+}
+
+void resetEnergy() {
+    noteEnergyReset(); // A running job keeps what it has used
+    for (int m = 0; m < ENERGY_MODE_COUNT; m++) {
+        energyWh[m] = 0;
+    }
+}
+
+// ENERGY idle=<Wh> active=<Wh> keepwarm=<Wh> reheat=<Wh> total=<Wh>
+void printEnergy() {
+    Serial.print(F("ENERGY"));
+    for (int m = 0; m < ENERGY_MODE_COUNT; m++) {
+        Serial.print(' ');
+        Serial.print((const __FlashStringHelper *)energyModeNames[m]);
+        Serial.print('=');
+        Serial.print(energyWh[m], 2);
+    }
+    Serial.print(F(" total="));
+    Serial.println(energyTotalWh(), 2);
+}
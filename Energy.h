@@ -0,0 +1,26 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <Arduino.h>
+
+// Contabilização de energia por modo de funcionamento
+enum EnergyMode {
+    ENERGY_IDLE = 0, // No segment active
+    ENERGY_ACTIVE,   // Normal control
+    ENERGY_KEEPWARM, // Holding the standby temperature
+    ENERGY_REHEAT,   // Heating back up for the next job
+    ENERGY_MODE_COUNT
+};
+
+// Nominal heater power of one segment at nominal mains voltage (W)
+extern float heaterWatts;
+extern float energyWh[ENERGY_MODE_COUNT];
+
+// Funções de energia
+float segmentPower(int segment);
+void accumulateEnergy();
+float energyTotalWh();
+void resetEnergy();
+void printEnergy();
+
+#endif
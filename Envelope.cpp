@@ -0,0 +1,142 @@
+#include "Envelope.h"
+#include "MY-HeatBed_Controller.h" // Para acessar NUM_SEGMENTS
+#include "TemperatureControl.h" // Para acessar sampleTemperature
+#include "ControlStrategy.h" // Para acessar segmentDuty
+
+unsigned long envelopeWindow = 0;
+unsigned long envelopeSampleMs = ENVELOPE_DEFAULT_SAMPLE;
+uint16_t envelopeMask = 0xFFFF;
+
+// Running aggregate of one channel over the current window
+struct EnvelopeChannel {
+    int16_t minValue;
+    int16_t maxValue;
+    int16_t last;
+    int32_t sum;
+    uint16_t count;
+};
+
+static EnvelopeChannel tempChannels[16];
+static EnvelopeChannel dutyChannels[16];
+static unsigned long windowStart = 0;
+static unsigned long lastSample = 0;
+
+static void clearChannel(EnvelopeChannel &ch) {
+    ch.minValue = 32767;
+    ch.maxValue = -32768;
+    ch.last = 0;
+    ch.sum = 0;
+    ch.count = 0;
+}
+
+static void addSample(EnvelopeChannel &ch, int16_t value) {
+    if (value < ch.minValue) ch.minValue = value;
+    if (value > ch.maxValue) ch.maxValue = value;
+    ch.last = value;
+    ch.sum += value;
+    ch.count++;
+}
+
+static void clearWindow() {
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        clearChannel(tempChannels[i]);
+        clearChannel(dutyChannels[i]);
+    }
+    windowStart = millis();
+}
+
+bool startEnvelope(unsigned long windowMs, unsigned long sampleMs) {
+    if (sampleMs < ENVELOPE_MIN_SAMPLE || windowMs < sampleMs) return false;
+    // Samples are at least sampleMs apart, so this bounds count per window
+    if (windowMs / sampleMs > ENVELOPE_MAX_SAMPLES) return false;
+    envelopeWindow = windowMs;
+    envelopeSampleMs = sampleMs;
+    clearWindow();
+    return true;
+}
+
+void stopEnvelope() {
+    envelopeWindow = 0;
+}
+
+// <min>:<max>:<mean>:<last>:<n>, or "-" for a channel without valid samples
+static void printChannel(const EnvelopeChannel &ch) {
+    if (ch.count == 0) {
+        Serial.print('-');
+        return;
+    }
+    Serial.print(ch.minValue);
+    Serial.print(':');
+    Serial.print(ch.maxValue);
+    Serial.print(':');
+    Serial.print((int16_t)(ch.sum / ch.count));
+    Serial.print(':');
+    Serial.print(ch.last);
+    Serial.print(':');
+    Serial.print(ch.count);
+}
+
+static void printFrame(const char *label, const EnvelopeChannel *channels, unsigned long now) {
+    Serial.print(F("ENV ms="));
+    Serial.print(now);
+    Serial.print(F(" win="));
+    Serial.print(now - windowStart);
+    Serial.print(' ');
+    Serial.print(label);
+    Serial.print('=');
+    bool first = true;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (!(envelopeMask & (1U << i))) continue;
+        if (!first) Serial.print(',');
+        printChannel(channels[i]);
+        first = false;
+    }
+    Serial.println();
+}
+
+// Scaled sample, clamped to the int16_t range so an out-of-range reading
+// saturates instead of wrapping
+static int16_t toSample(float value) {
+    if (value > 32767.0) return 32767;
+    if (value < -32768.0) return -32768;
+    return (int16_t)value;
+}
+
+// Called every loop pass: one sample per envelopeSampleMs, one pair of
+// frames per window
+void envelopeTelemetry() {
+    if (envelopeWindow == 0) return;
+    unsigned long now = millis();
+
+    if (now - lastSample >= envelopeSampleMs) {
+        lastSample = now;
+        for (int i = 0; i < NUM_SEGMENTS; i++) {
+            if (!(envelopeMask & (1U << i))) continue;
+            float temp = sampleTemperature(i); // Fresh reading, refreshes the cache too
+            if (temp != -999.0) {
+                addSample(tempChannels[i], toSample(temp * 100));
+            }
+            addSample(dutyChannels[i], toSample(segmentDuty[i] * 1000));
+        }
+    }
+
+    if (now - windowStart >= envelopeWindow) {
+        printFrame("T", tempChannels, now);
+        printFrame("D", dutyChannels, now);
+        clearWindow();
+    }
+}
+
+void printEnvelopeStatus() {
+    Serial.print(F("Envelope: "));
+    if (envelopeWindow == 0) {
+        Serial.println(F("OFF"));
+        return;
+    }
+    Serial.print(F("window "));
+    Serial.print(envelopeWindow);
+    Serial.print(F(" ms | sample "));
+    Serial.print(envelopeSampleMs);
+    Serial.print(F(" ms | mask 0x"));
+    Serial.println(envelopeMask, HEX);
+}
@@ -0,0 +1,26 @@
+#ifndef ENVELOPE_H
+#define ENVELOPE_H
+
+#include <Arduino.h>
+
+// Agregação de telemetria em envelopes (mín/máx/média/último/contagem).
+// Every channel is sampled at envelopeSampleMs and folded into the current
+// window in fixed point; one ENV frame per channel group is printed per window:
+// ENV ms=<end> win=<ms> T=<min>:<max>:<mean>:<last>:<n>,... (centi-°C)
+// ENV ms=<end> win=<ms> D=<min>:<max>:<mean>:<last>:<n>,... (duty per mille)
+
+#define ENVELOPE_MIN_SAMPLE 10   // Shortest sample period (ms)
+#define ENVELOPE_DEFAULT_SAMPLE 20 // 50 Hz
+#define ENVELOPE_MAX_SAMPLES 65000UL // Per window: keeps count in 16 bits and the sum in 32
+
+extern unsigned long envelopeWindow;   // Window length in ms, 0 = off
+extern unsigned long envelopeSampleMs; // Sample period in ms
+extern uint16_t envelopeMask;          // Segments included (bit i = segment i + 1)
+
+// Funções de envelope
+bool startEnvelope(unsigned long windowMs, unsigned long sampleMs);
+void stopEnvelope();
+void envelopeTelemetry();
+void printEnvelopeStatus();
+
+#endif
@@ -0,0 +1,281 @@
+#include "Field.h"
+#include <EEPROM.h>
+#include "TemperatureControl.h" // Para acessar cachedTemperatures
+#include "Storage.h"
+#include "Power.h" // Para acessar appliedPower e relaySwitches
+
+float surfaceOffset[16] = {0};
+float surfaceSlope[16] = {0};
+bool surfaceControl = false;
+
+#define SURFACE_MAGIC 0x5EF0
+
+struct SurfaceRecord {
+    uint16_t magic;
+    float offset[16];
+    float slope[16];
+    uint8_t checksum;
+};
+
+float surfaceTemperature(int segment, float sensorTemp) {
+    return sensorTemp + surfaceOffset[segment] + surfaceSlope[segment] * (sensorTemp - SURFACE_REF_TEMP);
+}
+
+void saveSurfaceOffsets() {
+    SurfaceRecord record;
+    record.magic = SURFACE_MAGIC;
+    for (int i = 0; i < 16; i++) {
+        record.offset[i] = surfaceOffset[i];
+        record.slope[i] = surfaceSlope[i];
+    }
+    record.checksum = storageChecksum(&record, sizeof(record));
+    EEPROM.put(SURFACE_EEPROM_ADDR, record);
+}
+
+bool loadSurfaceOffsets() {
+    SurfaceRecord record;
+    EEPROM.get(SURFACE_EEPROM_ADDR, record);
+    if (record.magic != SURFACE_MAGIC || record.checksum != storageChecksum(&record, sizeof(record))) {
+        return false;
+    }
+    for (int i = 0; i < 16; i++) {
+        surfaceOffset[i] = record.offset[i];
+        surfaceSlope[i] = record.slope[i];
+    }
+    return true;
+}
+
+void printSurfaceOffsets() {
+    Serial.print(F("Surface control: "));
+    Serial.println(surfaceControl ? F("ON") : F("OFF"));
+    for (int i = 0; i < 16; i++) {
+        Serial.print(F("Segment "));
+        Serial.print(i + 1);
+        Serial.print(F(" | Offset: "));
+        Serial.print(surfaceOffset[i]);
+        Serial.print(F("°C | Slope: "));
+        Serial.println(surfaceSlope[i], 4);
+    }
+}
+
+// Catmull-Rom cubic through p1..p2, with p0/p3 as neighbours, t in [0,1]
+static float cubic(float p0, float p1, float p2, float p3, float t) {
+    return p1 + 0.5 * t * (p2 - p0 + t * (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3 +
+                                         t * (3.0 * (p1 - p2) + p3 - p0)));
+}
+
+static float sensorAt(const float *sensors, int col, int row) {
+    col = constrain(col, 0, FIELD_SENSOR_COLS - 1);
+    row = constrain(row, 0, FIELD_SENSOR_ROWS - 1);
+    return sensors[row * FIELD_SENSOR_COLS + col];
+}
+
+// Bicubic interpolation at (x, y) in sensor-grid units (sensor 1 at 0,0).
+// Outside the sensor grid the edge values are held.
+float fieldAt(const float *sensors, float x, float y) {
+    x = constrain(x, 0.0, FIELD_SENSOR_COLS - 1.0);
+    y = constrain(y, 0.0, FIELD_SENSOR_ROWS - 1.0);
+    int cx = min((int)x, FIELD_SENSOR_COLS - 2);
+    int cy = min((int)y, FIELD_SENSOR_ROWS - 2);
+    float tx = x - cx;
+    float ty = y - cy;
+
+    float rows[4];
+    for (int j = 0; j < 4; j++) {
+        int r = cy - 1 + j;
+        rows[j] = cubic(sensorAt(sensors, cx - 1, r), sensorAt(sensors, cx, r),
+                        sensorAt(sensors, cx + 1, r), sensorAt(sensors, cx + 2, r), tx);
+    }
+    return cubic(rows[0], rows[1], rows[2], rows[3], ty);
+}
+
+// Surface estimate per sensor: cached reading through its offset curve.
+// Failed sensors (-999) take the mean of the valid ones.
+static void surfaceReadings(float *sensors) {
+    float sum = 0;
+    int count = 0;
+    for (int i = 0; i < 16; i++) {
+        if (cachedTemperatures[i] != -999.0) {
+            sensors[i] = surfaceTemperature(i, cachedTemperatures[i]);
+            sum += sensors[i];
+            count++;
+        }
+    }
+    float fallback = (count > 0) ? sum / count : 0;
+    for (int i = 0; i < 16; i++) {
+        if (cachedTemperatures[i] == -999.0) sensors[i] = fallback;
+    }
+}
+
+// Grid point k of n covers the whole bed, edge to edge
+static float gridCoord(int k, int n, int sensorsOnAxis) {
+    return -0.5 + (k + 0.5) * sensorsOnAxis / n;
+}
+
+// Walks the grid row by row without storing it: only the previous row is
+// kept for the gradient, so memory does not grow with the grid size
+void estimateField(int gridSize, FieldSummary &summary) {
+    float sensors[16];
+    float prevRow[FIELD_MAX_GRID];
+    surfaceReadings(sensors);
+
+    gridSize = constrain(gridSize, 2, FIELD_MAX_GRID);
+    float stepX = FIELD_SENSOR_COLS * FIELD_SEGMENT_PITCH_MM / gridSize;
+    float stepY = FIELD_SENSOR_ROWS * FIELD_SEGMENT_PITCH_MM / gridSize;
+
+    summary.minTemp = 1e9;
+    summary.maxTemp = -1e9;
+    summary.maxGradient = 0;
+    summary.gradX = summary.gradY = 0;
+    float sum = 0;
+
+    for (int j = 0; j < gridSize; j++) {
+        float y = gridCoord(j, gridSize, FIELD_SENSOR_ROWS);
+        float left = 0;
+        for (int i = 0; i < gridSize; i++) {
+            float x = gridCoord(i, gridSize, FIELD_SENSOR_COLS);
+            float t = fieldAt(sensors, x, y);
+            float px = (i + 0.5) * stepX;
+            float py = (j + 0.5) * stepY;
+            sum += t;
+
+            if (t < summary.minTemp) {
+                summary.minTemp = t;
+                summary.minX = px;
+                summary.minY = py;
+            }
+            if (t > summary.maxTemp) {
+                summary.maxTemp = t;
+                summary.maxX = px;
+                summary.maxY = py;
+            }
+
+            // Backward differences against the left and upper neighbours
+            float gx = (i > 0) ? (t - left) / stepX : 0;
+            float gy = (j > 0) ? (t - prevRow[i]) / stepY : 0;
+            float g = sqrt(gx * gx + gy * gy);
+            if (g > summary.maxGradient) {
+                summary.maxGradient = g;
+                summary.gradX = px;
+                summary.gradY = py;
+            }
+
+            if (i > 0) prevRow[i - 1] = left;
+            left = t;
+        }
+        prevRow[gridSize - 1] = left;
+    }
+    summary.meanTemp = sum / (gridSize * gridSize);
+}
+
+// FIELD n=<grid> min=<t>@<x>,<y> max=<t>@<x>,<y> mean=<t> grad=<°C/mm>@<x>,<y>
+void printFieldSummary(int gridSize) {
+    FieldSummary f;
+    gridSize = constrain(gridSize, 2, FIELD_MAX_GRID);
+    estimateField(gridSize, f);
+
+    Serial.print(F("FIELD n="));
+    Serial.print(gridSize);
+    Serial.print(F(" min="));
+    Serial.print(f.minTemp);
+    Serial.print('@');
+    Serial.print(f.minX, 0);
+    Serial.print(',');
+    Serial.print(f.minY, 0);
+    Serial.print(F(" max="));
+    Serial.print(f.maxTemp);
+    Serial.print('@');
+    Serial.print(f.maxX, 0);
+    Serial.print(',');
+    Serial.print(f.maxY, 0);
+    Serial.print(F(" mean="));
+    Serial.print(f.meanTemp);
+    Serial.print(F(" grad="));
+    Serial.print(f.maxGradient, 4);
+    Serial.print('@');
+    Serial.print(f.gradX, 0);
+    Serial.print(',');
+    Serial.println(f.gradY, 0);
+}
+
+// One comma-separated line per grid row, top row first
+void printFieldGrid(int gridSize) {
+    float sensors[16];
+    surfaceReadings(sensors);
+    gridSize = constrain(gridSize, 2, FIELD_MAX_GRID);
+
+    for (int j = 0; j < gridSize; j++) {
+        float y = gridCoord(j, gridSize, FIELD_SENSOR_ROWS);
+        Serial.print(F("FIELDROW "));
+        Serial.print(j);
+        Serial.print(' ');
+        for (int i = 0; i < gridSize; i++) {
+            if (i > 0) Serial.print(',');
+            Serial.print(fieldAt(sensors, gridCoord(i, gridSize, FIELD_SENSOR_COLS), y), 1);
+        }
+        Serial.println();
+    }
+}
+
+static unsigned long statsStart = 0;
+static unsigned long statsSamples = 0;
+static float spreadSum = 0;
+static float spreadMax = 0;
+static float powerSum = 0;
+static unsigned long statsSwitches[16]; // relaySwitches at the window start
+
+// Called once per control cycle
+void updateFieldStats() {
+    FieldSummary f;
+    estimateField(FIELD_STATS_GRID, f);
+    float spread = f.maxTemp - f.minTemp;
+    if (statsSamples == 0) {
+        statsStart = millis();
+        for (int i = 0; i < 16; i++) statsSwitches[i] = relaySwitches[i];
+    }
+    statsSamples++;
+    spreadSum += spread;
+    if (spread > spreadMax) spreadMax = spread;
+    powerSum += appliedPower();
+}
+
+void resetFieldStats() {
+    statsSamples = 0;
+    spreadSum = 0;
+    spreadMax = 0;
+    powerSum = 0;
+}
+
+// FIELDSTATS s=<s> spread=<mean>/<max> W=<mean> spreadPerKW=<°C/kW> sw/h=<mean>/<max>
+void printFieldStats() {
+    if (statsSamples == 0) {
+        Serial.println(F("FIELDSTATS no samples"));
+        return;
+    }
+    float seconds = (millis() - statsStart) / 1000.0;
+    float meanSpread = spreadSum / statsSamples;
+    float meanPower = powerSum / statsSamples;
+    float hours = seconds > 0 ? seconds / 3600.0 : 1;
+
+    unsigned long total = 0, most = 0;
+    for (int i = 0; i < 16; i++) {
+        unsigned long n = relaySwitches[i] - statsSwitches[i];
+        total += n;
+        if (n > most) most = n;
+    }
+
+    Serial.print(F("FIELDSTATS s="));
+    Serial.print(seconds, 0);
+    Serial.print(F(" spread="));
+    Serial.print(meanSpread);
+    Serial.print('/');
+    Serial.print(spreadMax);
+    Serial.print(F(" W="));
+    Serial.print(meanPower, 1);
+    Serial.print(F(" spreadPerKW="));
+    Serial.print(meanPower > 0 ? meanSpread * 1000.0 / meanPower : 0);
+    Serial.print(F(" sw/h="));
+    Serial.print(total / 16.0 / hours, 1);
+    Serial.print('/');
+    Serial.println(most / hours, 1);
+}
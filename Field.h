@@ -0,0 +1,50 @@
+#ifndef FIELD_H
+#define FIELD_H
+
+#include <Arduino.h>
+
+// Estimativa do campo de temperatura da cama entre os sensores
+
+// Sensors sit at the centre of each segment, row-major (segment 1 = top left)
+#define FIELD_SENSOR_COLS 4
+#define FIELD_SENSOR_ROWS 4
+// Distance between adjacent segment centres (in mm); adjust to the bed
+#define FIELD_SEGMENT_PITCH_MM 75.0
+// Default and maximum interpolation grid (points per axis)
+#define FIELD_DEFAULT_GRID 16
+#define FIELD_MAX_GRID 32
+
+// Surface offset curve per segment, e.g. fitted from IR camera frames:
+// surface = sensor + surfaceOffset + surfaceSlope * (sensor - SURFACE_REF_TEMP)
+#define SURFACE_REF_TEMP 25.0
+extern float surfaceOffset[16];
+extern float surfaceSlope[16];
+// When true, the control loop regulates the estimated surface temperature
+extern bool surfaceControl;
+
+// Uniformity statistics: the field is sampled on a coarse grid every control
+// cycle, with the applied power, so the measured spread per watt and relay
+// wear of this bed can be compared with candidate layouts off-line
+#define FIELD_STATS_GRID 8
+
+struct FieldSummary {
+    float minTemp, maxTemp, meanTemp;
+    float minX, minY, maxX, maxY; // Positions in mm from the bed corner
+    float maxGradient;            // °C/mm
+    float gradX, gradY;
+};
+
+// Funções do estimador de campo
+float surfaceTemperature(int segment, float sensorTemp);
+void saveSurfaceOffsets();
+bool loadSurfaceOffsets();
+void printSurfaceOffsets();
+float fieldAt(const float *sensors, float x, float y);
+void estimateField(int gridSize, FieldSummary &summary);
+void printFieldSummary(int gridSize);
+void printFieldGrid(int gridSize);
+void updateFieldStats();
+void resetFieldStats();
+void printFieldStats();
+
+#endif
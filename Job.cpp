@@ -0,0 +1,173 @@
+#include "Job.h"
+#include "MY-HeatBed_Controller.h" // Para acessar activeSegments e NUM_SECTIONS
+#include "TemperatureControl.h" // Para acessar cachedTemperatures
+#include "Setpoints.h" // Para acessar segmentSetpoint
+#include "Energy.h"
+#include "Power.h" // Para acessar relaySwitches
+#include "Ambient.h"
+
+#define SEGMENTS_PER_SECTION (NUM_SEGMENTS / NUM_SECTIONS)
+
+bool jobActive = false;
+
+static bool jobStarted = false; // Any job since power-up
+
+static unsigned long jobStartMs = 0;
+static unsigned long jobEndMs = 0;
+static long heatupSeconds[4];      // -1 until every active segment of the section is in band
+static float maxOvershoot = 0;     // Above setpoint, after heat-up
+static float sumSqError = 0;       // Tracking error after heat-up
+static unsigned long errorSamples = 0;
+static float maxSpread = 0;        // Heated segments, once all sections are up
+static unsigned long startSwitches[16];
+static unsigned long jobSwitches = 0;     // Totals frozen at JOB END
+static unsigned long jobMostSwitches = 0;
+static float startEnergyWh = 0;
+static float jobEnergyWh = 0;           // Consumed before the last ENERGY RESET, then the final figure
+static unsigned int jobFaults = 0;
+
+void startJob() {
+    jobStartMs = millis();
+    for (int s = 0; s < NUM_SECTIONS; s++) heatupSeconds[s] = -1;
+    maxOvershoot = 0;
+    sumSqError = 0;
+    errorSamples = 0;
+    maxSpread = 0;
+    for (int i = 0; i < NUM_SEGMENTS; i++) startSwitches[i] = relaySwitches[i];
+    startEnergyWh = energyTotalWh();
+    jobEnergyWh = 0;
+    jobSwitches = 0;
+    jobMostSwitches = 0;
+    jobFaults = 0;
+    jobActive = true;
+    jobStarted = true;
+}
+
+static float energySoFar() {
+    return jobEnergyWh + energyTotalWh() - startEnergyWh;
+}
+
+static void countSwitches(unsigned long &total, unsigned long &most) {
+    total = 0;
+    most = 0;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        unsigned long n = relaySwitches[i] - startSwitches[i];
+        total += n;
+        if (n > most) most = n;
+    }
+}
+
+// The finished job keeps its own figures: later relay switching and
+// ENERGY RESET no longer change them
+bool endJob() {
+    if (!jobActive) return false;
+    updateJobStats();
+    jobEndMs = millis();
+    jobEnergyWh = energySoFar();
+    countSwitches(jobSwitches, jobMostSwitches);
+    jobActive = false;
+    printJobStats();
+    return true;
+}
+
+void noteJobFault() {
+    if (jobActive) jobFaults++;
+}
+
+// Called by resetEnergy() before the counters are zeroed: the running job
+// banks what it used so far and counts on from zero
+void noteEnergyReset() {
+    if (!jobActive) return;
+    jobEnergyWh = energySoFar();
+    startEnergyWh = 0;
+}
+
+// Segments that are on, readable and asked to heat above ambient
+static bool heated(int i) {
+    return activeSegments[i] && cachedTemperatures[i] != -999.0 && segmentSetpoint[i] > ambientTemperature();
+}
+
+static bool sectionInBand(int s, bool &any) {
+    any = false;
+    for (int i = s * SEGMENTS_PER_SECTION; i < (s + 1) * SEGMENTS_PER_SECTION; i++) {
+        if (!heated(i)) continue;
+        any = true;
+        if (cachedTemperatures[i] < segmentSetpoint[i] - JOB_REACH_BAND) return false;
+    }
+    return any;
+}
+
+// Called every loop pass; samples every JOB_SAMPLE_MS
+void updateJobStats() {
+    static unsigned long lastSample = 0;
+    unsigned long now = millis();
+    if (!jobActive || now - lastSample < JOB_SAMPLE_MS) return;
+    lastSample = now;
+
+    bool allUp = true;
+    bool anyActive = false;
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        bool any;
+        bool up = sectionInBand(s, any);
+        if (up && heatupSeconds[s] < 0) {
+            heatupSeconds[s] = (now - jobStartMs) / 1000;
+        }
+        if (any) {
+            anyActive = true;
+            if (heatupSeconds[s] < 0) allUp = false;
+        }
+
+        if (heatupSeconds[s] < 0) continue;
+        for (int i = s * SEGMENTS_PER_SECTION; i < (s + 1) * SEGMENTS_PER_SECTION; i++) {
+            if (!heated(i)) continue;
+            float error = cachedTemperatures[i] - segmentSetpoint[i];
+            if (error > maxOvershoot) maxOvershoot = error;
+            sumSqError += error * error;
+            errorSamples++;
+        }
+    }
+
+    if (anyActive && allUp) {
+        float coldest = 1000, hottest = -1000;
+        for (int i = 0; i < NUM_SEGMENTS; i++) {
+            if (!heated(i)) continue;
+            if (cachedTemperatures[i] < coldest) coldest = cachedTemperatures[i];
+            if (cachedTemperatures[i] > hottest) hottest = cachedTemperatures[i];
+        }
+        if (hottest - coldest > maxSpread) maxSpread = hottest - coldest;
+    }
+}
+
+// While a job runs, the figures so far; after JOB END, the finished job
+void printJobStats() {
+    if (!jobStarted) {
+        Serial.println(F("JOB none"));
+        return;
+    }
+    unsigned long end = jobActive ? millis() : jobEndMs;
+    float energy = jobActive ? energySoFar() : jobEnergyWh;
+    unsigned long total = jobSwitches, most = jobMostSwitches;
+    if (jobActive) countSwitches(total, most);
+
+    Serial.print(F("JOB s="));
+    Serial.print((end - jobStartMs) / 1000);
+    Serial.print(F(" heat="));
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        if (s > 0) Serial.print(',');
+        Serial.print(heatupSeconds[s]);
+    }
+    Serial.print(F(" over="));
+    Serial.print(maxOvershoot);
+    Serial.print(F(" rms="));
+    Serial.print(errorSamples > 0 ? sqrt(sumSqError / errorSamples) : 0);
+    Serial.print(F(" spread="));
+    Serial.print(maxSpread);
+    Serial.print(F(" sw="));
+    Serial.print(total);
+    Serial.print('/');
+    Serial.print(most);
+    Serial.print(F(" Wh="));
+    Serial.print(energy, 2);
+    Serial.print(F(" faults="));
+    Serial.println(jobFaults);
+}
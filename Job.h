@@ -0,0 +1,24 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include <Arduino.h>
+
+// Estatísticas por trabalho, de JOB START a JOB END.
+// Accumulated incrementally in fixed-size counters and reported in one line:
+// JOB s=<s> heat=<s1>,<s2>,<s3>,<s4> over=<°C> rms=<°C> spread=<°C>
+//     sw=<total>/<max relay> Wh=<Wh> faults=<n>
+
+#define JOB_SAMPLE_MS 1000   // Statistics sampling period (in ms)
+#define JOB_REACH_BAND 1.0   // °C below the setpoint that counts as heated up
+
+extern bool jobActive;
+
+// Funções das estatísticas do trabalho
+void startJob();
+bool endJob();
+void updateJobStats();
+void noteJobFault();
+void noteEnergyReset();
+void printJobStats();
+
+#endif
@@ -0,0 +1,187 @@
+#include "KeepWarm.h"
+#include "MY-HeatBed_Controller.h" // Para acessar NUM_SEGMENTS e NUM_SECTIONS
+#include "ControlStrategy.h" // Para o modelo térmico e a troca sem saltos
+#include "Setpoints.h"
+#include "Telemetry.h"
+#include "Power.h"
+#include "Energy.h"
+#include "Trajectory.h"
+#include "Ambient.h"
+
+#define SEGMENTS_PER_SECTION (NUM_SEGMENTS / NUM_SECTIONS)
+
+uint8_t keepWarmState = KEEPWARM_OFF;
+
+static float standbyTemp = 0;
+static bool dueSet = false;
+static unsigned long dueAt = 0;
+static bool warmOn[16] = {false};
+
+void keepWarmStart(float standby, long dueSeconds) {
+    standbyTemp = standby;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        warmOn[i] = false;
+    }
+    keepWarmState = KEEPWARM_HOLD;
+    keepWarmSetDue(dueSeconds);
+}
+
+// dueSeconds <= 0: hold until KEEPWARM OFF or a due time is given
+void keepWarmSetDue(long dueSeconds) {
+    dueSet = dueSeconds > 0;
+    dueAt = millis() + dueSeconds * 1000UL;
+}
+
+// Hands the segments back to their strategies at the current duty
+static void resumeStrategies() {
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        setSectionStrategy(s, sectionStrategy[s]);
+    }
+}
+
+void keepWarmStop() {
+    if (keepWarmState == KEEPWARM_HOLD) resumeStrategies();
+    keepWarmState = KEEPWARM_OFF;
+}
+
+// Share of full power each active segment can get under POWER CAP
+static float availableDuty() {
+    int active = 0;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (activeSegments[i]) active++;
+    }
+    float full = active * heaterWatts;
+    if (powerCapWatts <= 0 || full <= powerCapWatts) return 1.0;
+    return powerCapWatts / full;
+}
+
+// Heat-up time from the first-order model at the available duty d:
+// T(t) = Tss - (Tss - T0) e^(-t/tau), Tss = ambient + heatRate * d * tau.
+// With ramps on, the setpoint cannot rise faster than RAMP RATE either.
+float estimateReheatSeconds(float from, float to) {
+    if (to <= from) return 0;
+    float steady = ambientTemperature() + modelHeatRate * availableDuty() * modelTau;
+    if (to >= steady || modelTau <= 0) return KEEPWARM_UNREACHABLE; // Not reachable per the model
+    float seconds = modelTau * log((steady - from) / (steady - to));
+    if (rampEnabled && rampMaxRate > 0) {
+        seconds = max(seconds, (to - from) / rampMaxRate);
+    }
+    return seconds;
+}
+
+// Worst active segment of a section; to <= 0 means the section's targetTemp
+float estimateSectionSeconds(int section, float to) {
+    float target = to > 0 ? to : targetTemp[section];
+    float worst = 0;
+    for (int i = section * SEGMENTS_PER_SECTION; i < (section + 1) * SEGMENTS_PER_SECTION; i++) {
+        if (!activeSegments[i] || cachedTemperatures[i] == -999.0) continue;
+        float t = estimateReheatSeconds(cachedTemperatures[i], target);
+        if (t > worst) worst = t;
+    }
+    return worst;
+}
+
+// ETA s=<slowest> sec=<s1>,<s2>,<s3>,<s4>, -1 where the model says unreachable
+void printTimeToSetpoint(float to) {
+    float sections[4];
+    float slowest = 0;
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        sections[s] = estimateSectionSeconds(s, to);
+        if (sections[s] > slowest) slowest = sections[s];
+    }
+    Serial.print(F("ETA s="));
+    Serial.print(slowest >= KEEPWARM_UNREACHABLE ? -1 : (long)slowest);
+    Serial.print(F(" sec="));
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        if (s > 0) Serial.print(',');
+        Serial.print(sections[s] >= KEEPWARM_UNREACHABLE ? -1 : (long)sections[s]);
+    }
+    Serial.println();
+}
+
+// Called at the end of updateSetpoints(): segmentSetpoint[] holds the job
+// setpoints, and is lowered to standby while holding
+void applyKeepWarm() {
+    if (keepWarmState == KEEPWARM_OFF) return;
+    unsigned long now = millis();
+
+    if (keepWarmState == KEEPWARM_HOLD && dueSet) {
+        // Slowest active segment decides when to start
+        float reheat = 0;
+        for (int i = 0; i < NUM_SEGMENTS; i++) {
+            // A failed sensor (-999) is not a cold segment: it is not heated
+            if (!activeSegments[i] || cachedTemperatures[i] == -999.0) continue;
+            float t = estimateReheatSeconds(cachedTemperatures[i], segmentSetpoint[i]);
+            if (t > reheat) reheat = t;
+        }
+        long remaining = (long)(dueAt - now) / 1000;
+        if (remaining <= reheat * KEEPWARM_REHEAT_MARGIN + KEEPWARM_REHEAT_SLACK) {
+            keepWarmState = KEEPWARM_REHEAT;
+            resumeStrategies();
+            emitEvent(F("KEEPWARM_REHEAT"), 0, reheat);
+        }
+    } else if (keepWarmState == KEEPWARM_REHEAT && (long)(now - dueAt) >= 0) {
+        keepWarmState = KEEPWARM_OFF;
+        emitEvent(F("KEEPWARM_READY"), 0, 0);
+    }
+
+    if (keepWarmState == KEEPWARM_HOLD) {
+        for (int i = 0; i < NUM_SEGMENTS; i++) {
+            if (segmentSetpoint[i] > standbyTemp) segmentSetpoint[i] = standbyTemp;
+        }
+    }
+}
+
+// Wide-band on/off while holding: the fewest relay switches that keep the
+// standby temperature, instead of time-proportioned duty
+float keepWarmDuty(int segment, float currentTemp, float target) {
+    if (currentTemp == -999.0) {
+        warmOn[segment] = false; // Never heat on a failed sensor
+    } else if (currentTemp < target - KEEPWARM_BAND) {
+        warmOn[segment] = true;
+    } else if (currentTemp > target + KEEPWARM_BAND) {
+        warmOn[segment] = false;
+    }
+    return warmOn[segment] ? 1.0 : 0.0;
+}
+
+static const char keepWarmStateNames[][7] PROGMEM = {"OFF", "HOLD", "REHEAT"};
+
+void printKeepWarm() {
+    Serial.print(F("Keep-warm: "));
+    Serial.print((const __FlashStringHelper *)keepWarmStateNames[keepWarmState]);
+    if (keepWarmState != KEEPWARM_OFF) {
+        Serial.print(F(" | Standby: "));
+        Serial.print(standbyTemp);
+        Serial.print(F("°C"));
+        if (dueSet) {
+            Serial.print(F(" | Due in: "));
+            Serial.print((long)(dueAt - millis()) / 1000);
+            Serial.print(F(" s"));
+        }
+    }
+    Serial.println();
+}
+
+void saveKeepWarm(KeepWarmRecord &rec) {
+    rec.state = keepWarmState;
+    rec.dueSet = dueSet;
+    rec.warmMask = 0;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (warmOn[i]) rec.warmMask |= (1U << i);
+    }
+    rec.standby = standbyTemp;
+    rec.dueInMs = (int32_t)(dueAt - millis());
+}
+
+void restoreKeepWarm(const KeepWarmRecord &rec) {
+    uint8_t state = rec.state <= KEEPWARM_REHEAT ? rec.state : (uint8_t)KEEPWARM_OFF;
+    if (keepWarmState == KEEPWARM_HOLD && state != KEEPWARM_HOLD) resumeStrategies();
+    keepWarmState = state;
+    dueSet = rec.dueSet;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        warmOn[i] = rec.warmMask & (1U << i);
+    }
+    standbyTemp = rec.standby;
+    dueAt = millis() + rec.dueInMs;
+}
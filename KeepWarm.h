@@ -0,0 +1,42 @@
+#ifndef KEEP_WARM_H
+#define KEEP_WARM_H
+
+#include <Arduino.h>
+
+// Modo de manutenção a temperatura reduzida entre trabalhos
+enum KeepWarmState {
+    KEEPWARM_OFF = 0,
+    KEEPWARM_HOLD,  // Standby temperature, wide hysteresis
+    KEEPWARM_REHEAT // Back on the job setpoints, ready at the due time
+};
+
+#define KEEPWARM_BAND 5.0          // ±°C around standby: few relay switches
+#define KEEPWARM_REHEAT_MARGIN 1.2 // Safety factor on the model's reheat time
+#define KEEPWARM_REHEAT_SLACK 60   // Extra seconds before the job is due
+#define KEEPWARM_UNREACHABLE 1e6   // Estimate for a temperature the model never reaches
+
+extern uint8_t keepWarmState;
+
+// Keep-warm state as STATE DUMP stores it; the due time as time left
+struct KeepWarmRecord {
+    uint8_t state;
+    uint8_t dueSet;
+    uint16_t warmMask; // Segments heating in the hold band
+    float standby;
+    int32_t dueInMs;
+};
+
+// Funções de keep-warm
+void keepWarmStart(float standby, long dueSeconds);
+void keepWarmSetDue(long dueSeconds);
+void keepWarmStop();
+void applyKeepWarm();
+float keepWarmDuty(int segment, float currentTemp, float target);
+float estimateReheatSeconds(float from, float to);
+float estimateSectionSeconds(int section, float to);
+void printTimeToSetpoint(float to);
+void printKeepWarm();
+void saveKeepWarm(KeepWarmRecord &rec);
+void restoreKeepWarm(const KeepWarmRecord &rec);
+
+#endif
@@ -0,0 +1,180 @@
+#include "Link.h"
+
+unsigned long linkBaud[LINK_PORT_COUNT] = {LINK_DEFAULT_BAUD, LINK_DEFAULT_BAUD};
+
+static const char portNames[LINK_PORT_COUNT][5] PROGMEM = {"USB", "DUET"};
+static const unsigned long supportedRates[] = {
+    9600, 19200, 38400, 57600, 115200, 250000, 500000, 1000000
+};
+
+struct LinkState {
+    unsigned long previousBaud; // Rate to fall back to while on probation
+    bool probation;
+    unsigned long windowStart;  // Probation or garbage-counting window
+    uint8_t garbage;
+};
+
+static LinkState links[LINK_PORT_COUNT];
+
+static HardwareSerial &portSerial(int port) {
+    return port == LINK_DUET ? Serial1 : Serial;
+}
+
+// UART clock error at this rate, in per mille. HardwareSerial::begin()
+// uses double speed (U2X): UBRR = (F_CPU / 4 / baud - 1) / 2
+int baudErrorPermille(unsigned long baud) {
+    unsigned long ubrr = (F_CPU / 4 / baud - 1) / 2;
+    unsigned long actual = F_CPU / (8 * (ubrr + 1));
+    long diff = (long)actual - (long)baud;
+    return (int)(diff * 1000 / (long)baud);
+}
+
+static bool rateSupported(unsigned long baud) {
+    for (unsigned int i = 0; i < sizeof(supportedRates) / sizeof(supportedRates[0]); i++) {
+        if (supportedRates[i] == baud) return true;
+    }
+    return false;
+}
+
+// Drains the transmit buffer at the old rate before reprogramming the UART
+static void switchBaud(int port, unsigned long baud) {
+    HardwareSerial &serial = portSerial(port);
+    serial.flush();
+    serial.end();
+    serial.begin(baud);
+    linkBaud[port] = baud;
+}
+
+static void fallBack(int port, const __FlashStringHelper *reason) {
+    unsigned long baud = links[port].probation ? links[port].previousBaud : LINK_DEFAULT_BAUD;
+    links[port].probation = false;
+    links[port].garbage = 0;
+    links[port].windowStart = millis();
+    switchBaud(port, baud);
+
+    Serial.print(F("BAUD FALLBACK "));
+    Serial.print((const __FlashStringHelper *)portNames[port]);
+    Serial.print(' ');
+    Serial.print(baud);
+    Serial.print(' ');
+    Serial.println(reason);
+}
+
+// Sends BENCH lines and times them until the last byte has left the UART.
+// The loop is blocked meanwhile, so it stops starting lines once two more
+// line times would exceed BAUD_BENCH_MAX_MS: the reply counts what was sent.
+static void runBenchmark(int port, long bytes) {
+    HardwareSerial &serial = portSerial(port);
+    char line[65];
+    for (int i = 0; i < 63; i++) {
+        line[i] = 'A' + (i % 26);
+    }
+    memcpy(line, "BENCH ", 6);
+    line[63] = '\n';
+    line[64] = '\0';
+
+    unsigned long lineUs = 640000000UL / linkBaud[port] + 1; // 64 bytes of 10 bits
+    serial.flush();
+    unsigned long startMicros = micros();
+    long sent = 0;
+    while (sent < bytes && micros() - startMicros + 2 * lineUs <= BAUD_BENCH_MAX_MS * 1000UL) {
+        serial.print(line);
+        sent += 64;
+    }
+    serial.flush();
+    unsigned long elapsed = micros() - startMicros;
+
+    float bytesPerSecond = elapsed > 0 ? sent * 1000000.0 / elapsed : 0;
+    Serial.print(F("BENCH port="));
+    Serial.print((const __FlashStringHelper *)portNames[port]);
+    Serial.print(F(" baud="));
+    Serial.print(linkBaud[port]);
+    Serial.print(F(" bytes="));
+    Serial.print(sent);
+    Serial.print(F(" us="));
+    Serial.print(elapsed);
+    Serial.print(F(" Bps="));
+    Serial.print(bytesPerSecond, 0);
+    Serial.print(F(" eff="));
+    Serial.print(bytesPerSecond * 1000.0 / linkBaud[port], 1); // 10 bits per byte
+    Serial.println(F("%"));
+}
+
+// BAUD commands, with the port they arrived on
+void processBaudCommand(int port, const String &command) {
+    String arg = command.length() > 5 ? command.substring(5) : String("");
+    arg.trim();
+    LinkState &link = links[port];
+
+    if (arg.length() == 0) {
+        printLinkStatus();
+    } else if (arg == "ACK") {
+        if (link.probation) {
+            link.probation = false;
+            link.garbage = 0;
+            link.windowStart = millis();
+            Serial.print(F("BAUD CONFIRMED "));
+            Serial.print((const __FlashStringHelper *)portNames[port]);
+            Serial.print(' ');
+            Serial.println(linkBaud[port]);
+        }
+    } else if (arg.startsWith("BENCH")) {
+        long bytes = arg.length() > 6 ? arg.substring(6).toInt() : BAUD_BENCH_DEFAULT;
+        runBenchmark(port, constrain(bytes, 64L, 65536L));
+    } else {
+        unsigned long baud = arg.toInt();
+        int error = rateSupported(baud) ? baudErrorPermille(baud) : 1000;
+        if (abs(error) > BAUD_MAX_ERROR_PERMILLE) {
+            Serial.println(F("Error: Usage BAUD <9600|19200|38400|57600|115200|250000|500000|1000000>."));
+            return;
+        }
+        // Reply at the old rate; the peer switches once it has seen it
+        portSerial(port).print(F("BAUD OK "));
+        portSerial(port).println(baud);
+        link.previousBaud = linkBaud[port];
+        link.probation = true;
+        link.garbage = 0;
+        link.windowStart = millis();
+        switchBaud(port, baud);
+    }
+}
+
+void noteLinkGarbage(int port) {
+    LinkState &link = links[port];
+    if (millis() - link.windowStart >= BAUD_PROBATION_MS) {
+        link.windowStart = millis();
+        link.garbage = 0;
+    }
+    link.garbage++;
+}
+
+// Called every loop pass. Silence only matters while the new rate is
+// unconfirmed, where no-ack covers it: a printer idle between jobs must
+// not lose a rate both sides have agreed on.
+void updateLinks() {
+    unsigned long now = millis();
+    for (int port = 0; port < LINK_PORT_COUNT; port++) {
+        LinkState &link = links[port];
+        bool fast = linkBaud[port] != LINK_DEFAULT_BAUD;
+
+        if (link.probation && now - link.windowStart >= BAUD_PROBATION_MS) {
+            fallBack(port, F("no-ack"));
+        } else if (fast && link.garbage > BAUD_MAX_GARBAGE) {
+            fallBack(port, F("errors"));
+        }
+    }
+}
+
+void printLinkStatus() {
+    for (int port = 0; port < LINK_PORT_COUNT; port++) {
+        Serial.print(F("Port "));
+        Serial.print((const __FlashStringHelper *)portNames[port]);
+        Serial.print(F(" | Baud: "));
+        Serial.print(linkBaud[port]);
+        Serial.print(F(" | Clock error: "));
+        Serial.print(baudErrorPermille(linkBaud[port]) / 10.0, 1);
+        Serial.print(F("%"));
+        if (links[port].probation) Serial.print(F(" | Awaiting BAUD ACK"));
+        Serial.println();
+    }
+}
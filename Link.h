@@ -0,0 +1,34 @@
+#ifndef LINK_H
+#define LINK_H
+
+#include <Arduino.h>
+
+// Negociação da velocidade das portas série (USB e Duet).
+// The peer sends BAUD <rate> on the port it wants changed; both sides switch,
+// and the peer must confirm with BAUD ACK at the new rate within the
+// probation time, or the port falls back to its previous rate. A confirmed
+// rate is kept however long the peer stays silent.
+
+enum LinkPort {
+    LINK_USB = 0,  // Serial
+    LINK_DUET,     // Serial1
+    LINK_PORT_COUNT
+};
+
+#define LINK_DEFAULT_BAUD 115200
+#define BAUD_PROBATION_MS 3000     // Time for the peer's BAUD ACK
+#define BAUD_MAX_GARBAGE 2         // Unrecognized lines tolerated in one probation window
+#define BAUD_MAX_ERROR_PERMILLE 25 // Largest clock error accepted (115200 is 2.1% at 16 MHz)
+#define BAUD_BENCH_DEFAULT 4096    // Bytes sent by BAUD BENCH
+#define BAUD_BENCH_MAX_MS 250      // Longest BAUD BENCH stall of the loop (safety checks wait)
+
+extern unsigned long linkBaud[LINK_PORT_COUNT];
+
+// Funções de ligação
+int baudErrorPermille(unsigned long baud);
+void processBaudCommand(int port, const String &command);
+void noteLinkGarbage(int port);
+void updateLinks();
+void printLinkStatus();
+
+#endif
@@ -27,6 +27,7 @@ extern const int tempTable[][2] PROGMEM;
 #define TEMP_HYSTERESIS 2.0
 #define PWM_TIMEOUT 25000
 #define DEBUG_INTERVAL 5000
+#define CONTROL_INTERVAL 5000
 #define SAFETY_TEMP_MAX 120.0
 #define PID_OUTPUT_THRESHOLD 0.5
 #define MAX_SAFE_TEMPERATURE 120.0
@@ -63,9 +64,9 @@ void setupPins();
 void updateAllSections();
 void printActiveSegmentsPeriodically();
 void checkThermalSafety();
-void resetThermalSafety();
+bool resetThermalSafety();
 float calculatePID(int segmentIndex, float currentTemp, float targetTemp);
-void controlHeatingWithPID(int secIndex, int start, int end);
+void controlSection(int secIndex, int start, int end);
 void debugMonitor();
 void updateTemperaturePWM(int secIndex, int start, int end);
 void printActiveSegments();
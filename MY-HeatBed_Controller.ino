@@ -19,6 +19,22 @@
 #include "SerialCommands.h"
 #include "Safety.h"
 #include "Debug.h"
+#include "Shadow.h"
+#include "ControlStrategy.h"
+#include "Calibration.h"
+#include "Field.h"
+#include "Telemetry.h"
+#include "Setpoints.h"
+#include "Mains.h"
+#include "Energy.h"
+#include "Schedule.h"
+#include "Envelope.h"
+#include "Link.h"
+#include "Macro.h"
+#include "Power.h"
+#include "Plant.h"
+#include "Ambient.h"
+#include "Job.h"
 
 // ====== Pin Definitions ======
 // Relay pins for the 16-segment heating module
@@ -44,34 +60,7 @@ const int pwmOutPins[4] = {5, 6, 7, 8};
 const int pwmInPins[4] = {9, 10, 11, 12};
 
 // ====== Temperature Control Variables ======
-// Target temperatures for each section
-float targetTemp[4] = {0, 0, 0, 0};
-
-// Array to track active segments (true = active, false = inactive)
-bool activeSegments[16] = {false}; // Initially, all segments are inactive
-
-// ====== Thermistor Configuration ======
-// Pull-up resistor value (adjust based on your circuit)
-#define PULLUP_RESISTOR 10000.0 // 10kΩ
-
-// Steinhart-Hart coefficients for a 100k NTC thermistor
-#define A 0.001129148
-#define B 0.000234125
-#define C 0.0000000876741
-
-// Temperature lookup table (ADC to temperature mapping)
-const int tempTable[][2] PROGMEM = {
-    {1, 300},    // ADC very low (~0°C)
-    {200, 250},  // ADC = 200 corresponds to ~250°C
-    {300, 200},  // Example: ADC 300 → 200°C
-    {400, 150},
-    {500, 120},
-    {600, 90},
-    {700, 60},
-    {800, 30},
-    {900, 10},
-    {1023, 0}
-};
+// targetTemp, activeSegments and the temperature lookup table live in tempControl.cpp
 
 // ====== Constants and Macros ======
 // Remover a definição de NUM_SEGMENTS daqui
@@ -80,6 +69,7 @@ const int tempTable[][2] PROGMEM = {
 #define TEMP_HYSTERESIS 2.0      // Temperature hysteresis (in °C)
 #define PWM_TIMEOUT 25000        // Timeout for PWM signal reading (in microseconds)
 #define DEBUG_INTERVAL 5000      // Interval for debug messages (in ms)
+#define CONTROL_INTERVAL 5000    // Interval between control updates (in ms)
 #define SAFETY_TEMP_MAX 120.0    // Maximum safe temperature (in °C)
 #define PID_OUTPUT_THRESHOLD 0.5 // Threshold for PID output to activate relays
 
@@ -89,16 +79,6 @@ int pwmMaxValue = 255; // Maximum PWM signal value
 float tempMin = 0.0;    // Minimum temperature corresponding to PWM
 float tempMax = 280.0;  // Maximum temperature corresponding to PWM
 
-// ====== Temperature Cache ======
-// Cache for storing temperature readings
-float cachedTemperatures[16] = {0};
-
-// Timestamps for the last temperature readings
-unsigned long lastReadTime[16] = {0};
-
-// Minimum interval between temperature readings (in ms)
-const unsigned long readInterval = 1000;
-
 // ====== PID Control Variables ======
 // PID gains
 float pidKp = 2.0; // Proportional gain
@@ -119,50 +99,84 @@ extern bool thermalSafetyTriggered; // Declare as external
 // ====== Function Prototypes ======
 // Apenas as funções que ainda estão neste arquivo
 void updateAllSections();
-void controlHeating(int segment, int start, int end);
-void setupPins();
-void updateTemperaturePWM(int section, int start, int end);
-void controlHeatingWithPID(int section, int start, int end); // Add this line
 
 // ====== Setup Function ======
 // Initializes the system, configures pins, and prints a startup message
 void setup() {
-    Serial.begin(115200); // Initialize Serial communication
-    Serial1.begin(115200);  // Comunicação com Duet
+    Serial.begin(LINK_DEFAULT_BAUD); // Initialize Serial communication (BAUD renegotiates)
+    Serial1.begin(LINK_DEFAULT_BAUD);  // Comunicação com Duet
     setupPins();          // Configure all pins
-    Serial.println("Arduino Mega ready to receive commands from Duet.");
-    Serial.println("Temperature control system initialized!");
+    if (loadCalibration()) {
+        Serial.println(F("PWM calibration loaded from EEPROM."));
+    }
+    if (loadSurfaceOffsets()) {
+        Serial.println(F("Surface offsets loaded from EEPROM."));
+    }
+    Serial.println(F("Arduino Mega ready to receive commands from Duet."));
+    Serial.println(F("Temperature control system initialized!"));
 }
 
 // ====== Main Loop ======
-// Handles commands, updates sections, and manages heating control
+// Handles commands, updates sections, and manages heating control.
+// Commands and telemetry are serviced on every pass; the control work runs
+// every CONTROL_INTERVAL without blocking, so streaming is not held up.
 void loop() {
-    if (!thermalSafetyTriggered) {
-        processSerialCommands();          // Process incoming Serial commands
-        updateAllSections();              // Update temperature and PWM for all sections
-        printActiveSegmentsPeriodically(); // Print active segments periodically
+    static unsigned long lastControlTime = 0;
+    static unsigned long lastMinorTime = 0;
+    static unsigned long lastSafetyMessage = 0;
+    unsigned long now = millis();
 
-        for (int i = 0; i < NUM_SECTIONS; i++) {
-            controlHeatingWithPID(i, i * (NUM_SEGMENTS / NUM_SECTIONS), (i * (NUM_SEGMENTS / NUM_SECTIONS)) + (NUM_SEGMENTS / NUM_SECTIONS) - 1);
-        }
+    processSerialCommands(); // Process incoming Serial commands (RESET_SAFETY included)
 
-        checkThermalSafety(); // Check for thermal safety violations
+    if (!thermalSafetyTriggered) {
+        if (now - lastControlTime >= CONTROL_INTERVAL) {
+            lastControlTime = now;
+            updateSetpoints();                // Apply staged/PWM setpoints at the tick boundary
+            updateMainsCompensation();        // Mains RMS -> duty factor, if enabled
+            updateAmbient();                  // Chamber temperature for the loss terms, if enabled
+            updateAllSections();              // Update temperature and PWM for all sections
+            updateFieldStats();               // Bed spread and power for FIELD STATS
+            printActiveSegmentsPeriodically(); // Print active segments periodically
+            printShadowStatsPeriodically();    // Stream shadow divergence, if enabled
+
+            if (debugMode) {
+                debugMonitor();
+            }
+        }
 
-        if (debugMode) {
-            debugMonitor();
+        if (now - lastMinorTime >= SCHEDULE_MINOR_MS) {
+            lastMinorTime = now;
+            accumulateEnergy();               // Energy of the duties held since the last cycle
+            runControlSchedule(now);          // Segments whose control period is due, fastest first
         }
-    } else {
-        Serial.println("System in thermal safety state. Use RESET_SAFETY command to reset.");
-        delay(DEBUG_INTERVAL); // Prevent message spamming
+
+        checkThermalSafety(); // Check for thermal safety violations (every SAFETY_INTERVAL)
+    } else if (now - lastSafetyMessage >= DEBUG_INTERVAL) {
+        lastSafetyMessage = now; // Prevent message spamming
+        Serial.println(F("System in thermal safety state. Use RESET_SAFETY command to reset."));
     }
-    delay(DEBUG_INTERVAL); // General delay to avoid overloading the system
+
+    streamTelemetry(); // Periodic SNAP lines, if enabled
+    envelopeTelemetry(); // Windowed ENV frames, if enabled
+    updateJobStats(); // Per-job statistics between JOB START and JOB END
+    updateLinks(); // BAUD probation and fallback
+    updateMacros(); // Resume a macro after its WAIT
+    updatePlantSim(); // A few steps of a running SIM
+    updateRelayOutputs(); // Time-proportioned, staggered relays under the power cap
 
     if (Serial1.available()) {
-        String recebido = Serial1.readStringUntil('\n');
-        recebido.trim();  // Remove extra characters
-        Serial.print("Recebido da Duet: ");
-        Serial.println(recebido);
-        processExternalCommand(recebido); // Process the received command
+        String recebido;
+        bool fits = readCommandLine(Serial1, recebido); // Bounded, already trimmed
+        noteDuetActivity(); // Feed the Duet link watchdog
+        if (!fits) {
+            garbageCommands++;
+            noteLinkGarbage(LINK_DUET);
+            Serial.println(F("Error: Command too long (Duet)."));
+        } else {
+            Serial.print(F("Recebido da Duet: "));
+            Serial.println(recebido);
+            processExternalCommand(recebido); // Process the received command
+        }
     }
 }
 
@@ -170,67 +184,5 @@ void loop() {
 void updateAllSections() {
     for (int i = 0; i < 4; i++) {
         updateTemperaturePWM(i, i * 4, (i * 4) + 3);
-        controlHeating(i, i * 4, (i * 4) + 3);
-    }
-}
-
-// ====== Function to control heating ======
-void controlHeating(int segment, int start, int end) {
-    // Implementation of controlHeating function
-}
-
-// ====== Function to setup pins ======
-void setupPins() {
-    // Define the pin setup logic here
-    // For example:
-    pinMode(LED_BUILTIN, OUTPUT);
-    // Add other pin setups as needed
-}
-
-// ====== Function to update temperature PWM ======
-void updateTemperaturePWM(int section, int start, int end) {
-    // Define the logic for updating temperature PWM here
-    // For example:
-    for (int i = start; i <= end; i++) {
-        // Read temperature from sensor
-        float temperature = analogRead(tempSensors[i]);
-        // Convert ADC value to temperature
-        // Apply PID control or other logic to update PWM
-        // Example: analogWrite(pwmOutPins[section], pwmValue);
     }
 }
-
-// ====== Function to control heating with PID ======
-void controlHeatingWithPID(int section, int start, int end) {
-    for (int i = start; i <= end; i++) {
-        // Read the current temperature
-        float currentTemp = analogRead(tempSensors[i]);
-
-        // Calculate the error
-        float error = targetTemp[section] - currentTemp;
-
-        // Calculate the integral term
-        pidIntegral[i] += error;
-
-        // Calculate the derivative term
-        float derivative = error - pidLastError[i];
-
-        // Calculate the PID output
-        float output = (pidKp * error) + (pidKi * pidIntegral[i]) + (pidKd * derivative);
-
-        // Update the last error
-        pidLastError[i] = error;
-
-        // Update the last PID update timestamp
-        pidLastUpdate[i] = millis();
-
-        // Control the relay based on the PID output
-        if (output > PID_OUTPUT_THRESHOLD) {
-            digitalWrite(relayPins[i], HIGH);
-            activeSegments[i] = true;
-        } else {
-            digitalWrite(relayPins[i], LOW);
-            activeSegments[i] = false;
-        }
-    }
-}
\ No newline at end of file
@@ -0,0 +1,467 @@
+#include "Macro.h"
+#include <EEPROM.h>
+#include "MY-HeatBed_Controller.h" // Para acessar targetTemp
+#include "Pins.h" // Para activateSegment e deactivateSegment
+#include "SerialCommands.h" // Para commandArg e processExtendedCommand
+#include "Safety.h"
+#include "Storage.h"
+#include "Telemetry.h"
+#include "Trajectory.h"
+
+#define MACRO_MAGIC 0x4D43
+
+// Opcodes. Each argument is a tag byte: ARG_INT (int16 follows),
+// ARG_FLOAT (float follows) or 1..9 for parameter $n
+enum MacroOp {
+    OP_END = 0,
+    OP_ON_ALL,
+    OP_OFF_ALL,
+    OP_ON,         // segment
+    OP_OFF,        // segment
+    OP_SET_TEMP,   // section, temp
+    OP_RAMP_QUEUE, // section, temp, hold s
+    OP_WAIT,       // ms
+    OP_TEXT        // length byte + command text, $n substituted when run
+};
+
+#define ARG_INT 0x10
+#define ARG_FLOAT 0x20
+
+static const char opNames[][11] PROGMEM = {"", "ON ALL", "OFF ALL", "ON", "OFF", "SET_TEMP", "RAMP QUEUE", "WAIT"};
+static const uint8_t opArgCount[] = {0, 0, 0, 1, 1, 2, 3, 1};
+
+// EEPROM table: header, then entries of
+// name[MACRO_NAME_LEN] | code length | code | checksum
+struct MacroHeader {
+    uint16_t magic;
+    uint16_t used; // Bytes of entries after the header
+};
+
+#define MACRO_TABLE_START (MACRO_EEPROM_ADDR + sizeof(MacroHeader))
+#define MACRO_ENTRY_OVERHEAD (MACRO_NAME_LEN + 2) // Name, length byte and checksum
+
+// Running macro
+static int runAddress = -1;   // Code start in EEPROM, -1 = idle
+static uint8_t runLength = 0;
+static uint8_t runPc = 0;
+static unsigned long wakeAt = 0;
+static bool waiting = false;
+static String runLine;        // RUN command, for $n lookups
+static char runName[MACRO_NAME_LEN + 1];
+
+static uint16_t tableUsed() {
+    MacroHeader header;
+    EEPROM.get(MACRO_EEPROM_ADDR, header);
+    return header.magic == MACRO_MAGIC ? header.used : 0;
+}
+
+static void setTableUsed(uint16_t used) {
+    MacroHeader header;
+    header.magic = MACRO_MAGIC;
+    header.used = used;
+    EEPROM.put(MACRO_EEPROM_ADDR, header);
+}
+
+static bool nameMatches(int address, const String &name) {
+    for (int i = 0; i < MACRO_NAME_LEN; i++) {
+        char c = EEPROM.read(address + i);
+        char n = i < (int)name.length() ? name.charAt(i) : 0;
+        if (c != n) return false;
+        if (c == 0) return true;
+    }
+    return true;
+}
+
+// Bytes taken by the entry at address; every walk of the table steps by this
+static int entrySize(int address) {
+    return MACRO_ENTRY_OVERHEAD + EEPROM.read(address + MACRO_NAME_LEN);
+}
+
+// Address of the entry, or -1
+static int findMacro(const String &name) {
+    uint16_t used = tableUsed();
+    int address = MACRO_TABLE_START;
+    while (address < (int)(MACRO_TABLE_START + used)) {
+        if (nameMatches(address, name)) return address;
+        address += entrySize(address);
+    }
+    return -1;
+}
+
+static bool entryValid(int address) {
+    uint8_t length = EEPROM.read(address + MACRO_NAME_LEN);
+    uint8_t sum = 0;
+    for (int i = 0; i < MACRO_NAME_LEN + 1 + length; i++) {
+        sum += EEPROM.read(address + i);
+    }
+    return sum == EEPROM.read(address + MACRO_NAME_LEN + 1 + length);
+}
+
+// ---- Compiler ----
+
+static bool emitByte(uint8_t *code, int &length, uint8_t value) {
+    if (length >= MACRO_MAX_CODE) return false;
+    code[length++] = value;
+    return true;
+}
+
+static bool emitBytes(uint8_t *code, int &length, const void *data, int size) {
+    for (int i = 0; i < size; i++) {
+        if (!emitByte(code, length, ((const uint8_t *)data)[i])) return false;
+    }
+    return true;
+}
+
+// A number or $n; false if the token is neither
+static bool emitArg(uint8_t *code, int &length, const String &token) {
+    if (token.length() == 2 && token.charAt(0) == '$' && token.charAt(1) >= '1' && token.charAt(1) <= '9') {
+        return emitByte(code, length, token.charAt(1) - '0');
+    }
+    bool dot = false;
+    for (unsigned int i = 0; i < token.length(); i++) {
+        char c = token.charAt(i);
+        if (c == '.' && !dot) dot = true;
+        else if (!(isDigit(c) || (i == 0 && c == '-'))) return false;
+    }
+    if (token.length() == 0) return false;
+
+    float value = token.toFloat();
+    if (!dot && value >= -32768 && value <= 32767) {
+        int16_t whole = token.toInt();
+        return emitByte(code, length, ARG_INT) && emitBytes(code, length, &whole, sizeof(whole));
+    }
+    return emitByte(code, length, ARG_FLOAT) && emitBytes(code, length, &value, sizeof(value));
+}
+
+// One step; known commands become opcodes, anything else is kept as text
+static bool compileStep(uint8_t *code, int &length, const String &step) {
+    int op = -1;
+    int firstArg = 1;
+    if (step == "ON ALL") { op = OP_ON_ALL; firstArg = 2; }
+    else if (step == "OFF ALL") { op = OP_OFF_ALL; firstArg = 2; }
+    else if (step.startsWith("ON ")) op = OP_ON;
+    else if (step.startsWith("OFF ")) op = OP_OFF;
+    else if (step.startsWith("SET_TEMP ")) op = OP_SET_TEMP;
+    else if (step.startsWith("RAMP QUEUE ")) { op = OP_RAMP_QUEUE; firstArg = 2; }
+    else if (step.startsWith("WAIT ")) op = OP_WAIT;
+
+    if (op >= 0) {
+        int start = length;
+        bool ok = emitByte(code, length, op);
+        for (int a = 0; ok && a < opArgCount[op]; a++) {
+            String token = commandArg(step, firstArg + a);
+            if (token.length() == 0 && op == OP_RAMP_QUEUE && a == 2) token = "0"; // Hold is optional
+            ok = emitArg(code, length, token);
+        }
+        if (ok && commandArg(step, firstArg + opArgCount[op]).length() == 0) return true;
+        length = start;
+        if (op == OP_WAIT) return false; // WAIT only exists inside macros
+    }
+
+    if (step.startsWith("RUN ") || step.startsWith("MACRO ") || step.length() > 255) return false;
+    if (!emitByte(code, length, OP_TEXT) || !emitByte(code, length, step.length())) return false;
+    for (unsigned int i = 0; i < step.length(); i++) {
+        if (!emitByte(code, length, step.charAt(i))) return false;
+    }
+    return true;
+}
+
+bool defineMacro(const String &name, const String &steps) {
+    if (name.length() == 0 || name.length() > MACRO_NAME_LEN) {
+        Serial.println(F("Error: Macro names have 1 to 8 characters."));
+        return false;
+    }
+
+    uint8_t code[MACRO_MAX_CODE];
+    int length = 0;
+    int start = 0;
+    while (start <= (int)steps.length()) {
+        int end = steps.indexOf(';', start);
+        if (end < 0) end = steps.length();
+        String step = steps.substring(start, end);
+        step.trim();
+        if (step.length() > 0 && !compileStep(code, length, step)) {
+            Serial.print(F("Error: Cannot compile macro step \""));
+            Serial.print(step);
+            Serial.println(F("\"."));
+            return false;
+        }
+        start = end + 1;
+    }
+    if (length == 0) {
+        Serial.println(F("Error: Empty macro."));
+        return false;
+    }
+
+    if (runAddress >= 0) stopMacro(); // The table is about to move
+    deleteMacro(name);
+    uint16_t used = tableUsed();
+    int size = MACRO_ENTRY_OVERHEAD + length;
+    if (sizeof(MacroHeader) + used + size > MACRO_EEPROM_SIZE) {
+        Serial.println(F("Error: Macro storage full."));
+        return false;
+    }
+
+    int address = MACRO_TABLE_START + used;
+    uint8_t sum = 0;
+    for (int i = 0; i < MACRO_NAME_LEN; i++) {
+        uint8_t c = i < (int)name.length() ? name.charAt(i) : 0;
+        EEPROM.update(address + i, c);
+        sum += c;
+    }
+    EEPROM.update(address + MACRO_NAME_LEN, length);
+    sum += length;
+    for (int i = 0; i < length; i++) {
+        EEPROM.update(address + MACRO_NAME_LEN + 1 + i, code[i]);
+        sum += code[i];
+    }
+    EEPROM.update(address + MACRO_NAME_LEN + 1 + length, sum);
+    setTableUsed(used + size);
+
+    Serial.print(F("Macro "));
+    Serial.print(name);
+    Serial.print(F(" stored ("));
+    Serial.print(length);
+    Serial.println(F(" bytes)."));
+    return true;
+}
+
+// Later entries are moved down over the deleted one
+bool deleteMacro(const String &name) {
+    int address = findMacro(name);
+    if (address < 0) return false;
+    if (runAddress >= 0) stopMacro();
+
+    uint16_t used = tableUsed();
+    int size = entrySize(address);
+    int end = MACRO_TABLE_START + used;
+    for (int i = address; i + size < end; i++) {
+        EEPROM.update(i, EEPROM.read(i + size));
+    }
+    setTableUsed(used - size);
+    return true;
+}
+
+void clearMacros() {
+    stopMacro();
+    setTableUsed(0);
+}
+
+// ---- Interpreter ----
+
+// Reads the argument at base + pc and advances pc past it
+static float fetchArg(int base, int &pc) {
+    int address = base + pc;
+    uint8_t tag = EEPROM.read(address);
+    if (tag == ARG_INT) {
+        int16_t value;
+        EEPROM.get(address + 1, value);
+        pc += 1 + sizeof(value);
+        return value;
+    }
+    if (tag == ARG_FLOAT) {
+        float value;
+        EEPROM.get(address + 1, value);
+        pc += 1 + sizeof(value);
+        return value;
+    }
+    pc += 1;
+    return commandArg(runLine, 1 + tag).toFloat(); // $n: RUN <name> p1 ... p9
+}
+
+// Text step with $1..$9 replaced by the RUN parameters
+static String fetchText(int base, int &pc) {
+    uint8_t length = EEPROM.read(base + pc);
+    String text;
+    for (int i = 0; i < length; i++) {
+        char c = EEPROM.read(base + pc + 1 + i);
+        char next = i + 1 < length ? EEPROM.read(base + pc + 2 + i) : 0;
+        if (c == '$' && next >= '1' && next <= '9') {
+            text += commandArg(runLine, 1 + (next - '0'));
+            i++;
+        } else {
+            text += c;
+        }
+    }
+    pc += 1 + length;
+    return text;
+}
+
+static void finishMacro(const char *how) {
+    Serial.print(F("Macro "));
+    Serial.print(runName);
+    Serial.print(' ');
+    Serial.println(how);
+    runAddress = -1;
+    waiting = false;
+}
+
+// Runs steps until the macro ends or reaches a WAIT
+static void executeSteps() {
+    int pc = runPc;
+    while (pc < runLength) {
+        if (thermalSafetyTriggered) {
+            finishMacro("aborted: thermal safety.");
+            return;
+        }
+
+        uint8_t op = EEPROM.read(runAddress + pc++);
+        if (op == OP_TEXT) {
+            String text = fetchText(runAddress, pc);
+            if (!processExtendedCommand(text)) {
+                Serial.print(F("Error: Macro step not recognized: "));
+                Serial.println(text);
+            }
+            continue;
+        }
+        if (op >= OP_TEXT || op == OP_END) {
+            finishMacro("aborted: bad opcode.");
+            return;
+        }
+
+        float args[3];
+        for (int a = 0; a < opArgCount[op]; a++) {
+            args[a] = fetchArg(runAddress, pc);
+        }
+
+        switch (op) {
+            case OP_ON_ALL:
+                activateAllSegments();
+                break;
+            case OP_OFF_ALL:
+                deactivateAllSegments();
+                break;
+            case OP_ON:
+                if (args[0] >= 1 && args[0] <= 16) activateSegment((int)args[0]);
+                break;
+            case OP_OFF:
+                if (args[0] >= 1 && args[0] <= 16) deactivateSegment((int)args[0]);
+                break;
+            case OP_SET_TEMP: {
+                int section = (int)args[0];
+                if (section >= 1 && section <= 4 && args[1] >= 0 && args[1] <= SAFETY_TEMP_MAX) {
+                    targetTemp[section - 1] = args[1];
+                    clearRampQueue(section - 1);
+                    emitEvent(F("SETPOINT"), section, args[1]);
+                }
+                break;
+            }
+            case OP_RAMP_QUEUE: {
+                int section = (int)args[0];
+                if (section >= 1 && section <= 4 && args[1] >= 0 && args[1] <= SAFETY_TEMP_MAX) {
+                    if (!queueRamp(section - 1, args[1], (unsigned long)args[2])) {
+                        Serial.println(F("Error: Macro RAMP QUEUE rejected (needs RAMP ON, SETPOINT_SOURCE SERIAL, free slot)."));
+                    }
+                }
+                break;
+            }
+            case OP_WAIT:
+                runPc = pc;
+                wakeAt = millis() + (unsigned long)args[0];
+                waiting = true;
+                return;
+        }
+    }
+    finishMacro("done.");
+}
+
+bool runMacro(const String &command) {
+    String name = commandArg(command, 1);
+    if (runAddress >= 0) {
+        Serial.print(F("Error: Macro "));
+        Serial.print(runName);
+        Serial.println(F(" is running (MACRO STOP)."));
+        return false;
+    }
+    int address = findMacro(name);
+    if (address < 0 || !entryValid(address)) {
+        Serial.println(F("Error: Unknown or corrupted macro."));
+        return false;
+    }
+
+    name.toCharArray(runName, sizeof(runName));
+    runLine = command;
+    runLength = EEPROM.read(address + MACRO_NAME_LEN);
+    runAddress = address + MACRO_NAME_LEN + 1;
+    runPc = 0;
+    waiting = false;
+    executeSteps();
+    return true;
+}
+
+void stopMacro() {
+    if (runAddress >= 0) finishMacro("stopped.");
+}
+
+// Called every loop pass: resumes a macro after its WAIT
+void updateMacros() {
+    if (runAddress >= 0 && waiting && (long)(millis() - wakeAt) >= 0) {
+        waiting = false;
+        executeSteps();
+    }
+}
+
+void listMacros() {
+    uint16_t used = tableUsed();
+    int address = MACRO_TABLE_START;
+    Serial.print(F("Macros ("));
+    Serial.print(used);
+    Serial.print(F(" of "));
+    Serial.print(MACRO_EEPROM_SIZE - sizeof(MacroHeader));
+    Serial.println(F(" bytes used):"));
+    while (address < (int)(MACRO_TABLE_START + used)) {
+        uint8_t length = EEPROM.read(address + MACRO_NAME_LEN);
+        Serial.print(F("  "));
+        for (int i = 0; i < MACRO_NAME_LEN; i++) {
+            char c = EEPROM.read(address + i);
+            if (c == 0) break;
+            Serial.print(c);
+        }
+        Serial.print(F(" | "));
+        Serial.print(length);
+        Serial.print(F(" bytes"));
+        if (!entryValid(address)) Serial.print(F(" | CORRUPTED"));
+        Serial.println();
+        address += entrySize(address);
+    }
+}
+
+// Prints the compiled steps back as commands
+bool showMacro(const String &name) {
+    int address = findMacro(name);
+    if (address < 0) return false;
+
+    int base = address + MACRO_NAME_LEN + 1;
+    int length = EEPROM.read(address + MACRO_NAME_LEN);
+    int pc = 0;
+    while (pc < length) {
+        uint8_t op = EEPROM.read(base + pc++);
+        Serial.print(F("  "));
+        if (op == OP_TEXT) {
+            uint8_t textLength = EEPROM.read(base + pc);
+            for (int i = 0; i < textLength; i++) {
+                Serial.print((char)EEPROM.read(base + pc + 1 + i));
+            }
+            Serial.println();
+            pc += 1 + textLength;
+            continue;
+        }
+        if (op == OP_END || op > OP_TEXT) break;
+        Serial.print((const __FlashStringHelper *)opNames[op]);
+        for (int a = 0; a < opArgCount[op]; a++) {
+            uint8_t tag = EEPROM.read(base + pc);
+            Serial.print(' ');
+            if (tag >= 1 && tag <= MACRO_MAX_PARAMS) {
+                Serial.print('$');
+                Serial.print(tag);
+                pc++;
+            } else {
+                float value = fetchArg(base, pc);
+                if (tag == ARG_INT) Serial.print((int)value);
+                else Serial.print(value, 3);
+            }
+        }
+        Serial.println();
+    }
+    return true;
+}
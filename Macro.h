@@ -0,0 +1,24 @@
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <Arduino.h>
+
+// Macros de comandos guardadas na EEPROM e executadas localmente.
+// MACRO DEFINE <name> <cmd>;<cmd>;... compiles the steps once into opcodes;
+// RUN <name> [p1 ... p9] executes them, with $1..$9 replaced by the parameters.
+
+#define MACRO_NAME_LEN 8   // Longest macro name
+#define MACRO_MAX_CODE 160 // Compiled bytes per macro
+#define MACRO_MAX_PARAMS 9
+
+// Funções de macros
+bool defineMacro(const String &name, const String &steps);
+bool deleteMacro(const String &name);
+void clearMacros();
+bool runMacro(const String &command);
+void stopMacro();
+void updateMacros();
+void listMacros();
+bool showMacro(const String &name);
+
+#endif
@@ -0,0 +1,132 @@
+#include "Mains.h"
+
+bool mainsCompensation = false;
+uint16_t mainsFactorQ12 = MAINS_FACTOR_ONE;
+
+static float mainsNominal = 230.0;  // V
+static float mainsScale = 0;        // V per ADC count (RMS), set by MAINS CAL
+static uint16_t rmsFilteredQ4 = 0;  // Filtered RMS in ADC counts, Q4
+static uint16_t nominalCounts = 0;  // Nominal voltage in ADC counts
+static float externalVolts = 0;     // Last value pushed with MAINS SET
+
+static uint16_t isqrt32(uint32_t x) {
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > x) bit >>= 2;
+    while (bit != 0) {
+        if (x >= result + bit) {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+// (nominal / rms)² in Q12, both in ADC counts
+static uint16_t factorFromCounts(uint16_t rmsCounts) {
+    if (rmsCounts == 0 || nominalCounts == 0) return MAINS_FACTOR_ONE;
+    uint32_t num = ((uint32_t)nominalCounts * nominalCounts) << 12;
+    uint32_t factor = num / ((uint32_t)rmsCounts * rmsCounts);
+    return constrain(factor, (uint32_t)MAINS_FACTOR_MIN, (uint32_t)MAINS_FACTOR_MAX);
+}
+
+// One-cycle burst, two passes over the samples in integer arithmetic:
+// mean (the bias), then the sum of squared deviations. Samples are paced
+// against micros() deadlines, so the ~112 µs of each analogRead is part of
+// the spacing and the burst covers exactly one cycle whatever the phase.
+static uint16_t sampleMainsRms() {
+    int16_t samples[MAINS_SAMPLES];
+    int32_t sum = 0;
+    unsigned long next = micros();
+    for (int i = 0; i < MAINS_SAMPLES; i++) {
+        while ((long)(micros() - next) < 0) {
+            // Wait for this sample's slot
+        }
+        next += MAINS_SAMPLE_US;
+        samples[i] = analogRead(MAINS_SENSE_PIN);
+        sum += samples[i];
+    }
+    int16_t mean = sum / MAINS_SAMPLES;
+    uint32_t sumSq = 0;
+    for (int i = 0; i < MAINS_SAMPLES; i++) {
+        int32_t d = samples[i] - mean;
+        sumSq += d * d;
+    }
+    return isqrt32(sumSq / MAINS_SAMPLES);
+}
+
+// Called once per control tick
+void updateMainsCompensation() {
+    if (!mainsCompensation) {
+        mainsFactorQ12 = MAINS_FACTOR_ONE;
+        return;
+    }
+
+    if (MAINS_SENSE_PIN >= 0 && mainsScale > 0) {
+        uint16_t rms = sampleMainsRms();
+        // First-order filter, 1/8 per tick: mains drifts slowly
+        if (rmsFilteredQ4 == 0) {
+            rmsFilteredQ4 = rms << 4;
+        } else {
+            rmsFilteredQ4 += ((int16_t)((rms << 4) - rmsFilteredQ4)) >> 3;
+        }
+        mainsFactorQ12 = factorFromCounts(rmsFilteredQ4 >> 4);
+    } else if (externalVolts > 0) {
+        float ratio = mainsNominal / externalVolts;
+        uint32_t factor = ratio * ratio * MAINS_FACTOR_ONE;
+        mainsFactorQ12 = constrain(factor, (uint32_t)MAINS_FACTOR_MIN, (uint32_t)MAINS_FACTOR_MAX);
+    } else {
+        mainsFactorQ12 = MAINS_FACTOR_ONE;
+    }
+}
+
+void setMainsVoltage(float volts) {
+    externalVolts = volts;
+}
+
+float mainsNominalVoltage() {
+    return mainsNominal;
+}
+
+void setMainsNominal(float volts) {
+    mainsNominal = volts;
+    if (mainsScale > 0) nominalCounts = mainsNominal / mainsScale;
+}
+
+// Ties the RMS in ADC counts measured now to a known voltage
+bool calibrateMains(float volts) {
+    if (MAINS_SENSE_PIN < 0 || volts <= 0) return false;
+    uint16_t rms = sampleMainsRms();
+    if (rms == 0) return false;
+    mainsScale = volts / rms;
+    rmsFilteredQ4 = rms << 4;
+    nominalCounts = mainsNominal / mainsScale;
+    return true;
+}
+
+float mainsVoltage() {
+    if (MAINS_SENSE_PIN >= 0 && mainsScale > 0) {
+        return (rmsFilteredQ4 >> 4) * mainsScale;
+    }
+    return externalVolts;
+}
+
+// Delivered power ~ duty * V², so scaling the duty by (Vnominal / V)²
+// keeps the power constant
+float compensateDuty(float duty) {
+    return constrain(duty * mainsFactorQ12 / MAINS_FACTOR_ONE, 0.0, 1.0);
+}
+
+void printMainsStatus() {
+    Serial.print(F("Mains compensation: "));
+    Serial.print(mainsCompensation ? F("ON") : F("OFF"));
+    Serial.print(F(" | Voltage: "));
+    Serial.print(mainsVoltage());
+    Serial.print(F(" V | Nominal: "));
+    Serial.print(mainsNominal);
+    Serial.print(F(" V | Factor: "));
+    Serial.println((float)mainsFactorQ12 / MAINS_FACTOR_ONE, 3);
+}
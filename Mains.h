@@ -0,0 +1,31 @@
+#ifndef MAINS_H
+#define MAINS_H
+
+#include <Arduino.h>
+
+// Compensação da tensão da rede: a potência do aquecedor varia com V²
+
+// Analog pin of the mains sense transformer (biased at mid-scale).
+// All 16 analog inputs of the shield are thermistors, so it is off by
+// default; MAINS SET <V> lets the Duet push a measured value instead.
+#define MAINS_SENSE_PIN -1
+#define MAINS_SAMPLES 64        // Samples per RMS burst
+#define MAINS_SAMPLE_US 312     // Sample spacing: 64 x 312 µs = one 50 Hz cycle (20 ms)
+#define MAINS_FACTOR_ONE 4096   // Q12 fixed point: 4096 = 1.0
+#define MAINS_FACTOR_MIN 2867   // 0.70
+#define MAINS_FACTOR_MAX 6144   // 1.50
+
+extern bool mainsCompensation;
+extern uint16_t mainsFactorQ12; // Duty multiplier, (Vnominal / Vrms)²
+
+// Funções da compensação da rede
+void updateMainsCompensation();
+void setMainsVoltage(float volts);
+void setMainsNominal(float volts);
+bool calibrateMains(float volts);
+float mainsVoltage();
+float mainsNominalVoltage();
+float compensateDuty(float duty);
+void printMainsStatus();
+
+#endif
@@ -0,0 +1,183 @@
+#include "Plant.h"
+#include "MY-HeatBed_Controller.h" // Para acessar CONTROL_INTERVAL
+#include "TemperatureControl.h" // Para acessar cachedTemperatures e computePID
+#include "ControlStrategy.h" // Para acessar modelHeatRate e modelTau
+#include "Ambient.h"
+#include "Field.h" // Para acessar FIELD_SENSOR_COLS/ROWS
+
+float plantCoupling = 0.002;
+
+enum PlantMode { PLANT_IDLE = 0, PLANT_RUN, PLANT_CHECK };
+static uint8_t plantMode = PLANT_IDLE;
+
+// One array per quantity, indexed by segment, so each step is a few flat loops
+static float simTemp[16];
+static float simStart[16];
+static float simDuty[16];
+static float simFlow[16];
+static float simIntegral[16];
+static float simLastError[16];
+static long simReach[16]; // Simulated second the segment reached the band, -1 = not yet
+
+static float simTarget = 0;
+static float simKp = 0, simKi = 0, simKd = 0;
+static long simSeconds = 0;  // Requested length
+static long simElapsed = 0;  // Simulated so far
+static float simPeak = 0;    // Hottest segment seen
+static float checkError = 0; // Largest deviation from the closed-form solution
+static unsigned long simMicros = 0; // Time spent stepping
+
+static void initPlant(long seconds) {
+    for (int i = 0; i < 16; i++) {
+        float t = cachedTemperatures[i];
+        simTemp[i] = (t == -999.0) ? ambientTemperature() : t;
+        simStart[i] = simTemp[i];
+        simDuty[i] = 0;
+        simIntegral[i] = 0;
+        simLastError[i] = 0;
+        simReach[i] = -1;
+    }
+    simSeconds = seconds;
+    simElapsed = 0;
+    simPeak = 0;
+    checkError = 0;
+    simMicros = 0;
+}
+
+bool startPlantSim(float target, long seconds, float kp, float ki, float kd) {
+    if (target <= ambientTemperature() || seconds <= 0 || seconds > PLANT_MAX_SECONDS) return false;
+    initPlant(seconds);
+    simTarget = target;
+    simKp = kp;
+    simKi = ki;
+    simKd = kd;
+    plantMode = PLANT_RUN;
+    return true;
+}
+
+// Full duty, no coupling: every segment must follow the exact solution of
+// the model, T(t) = Ts - (Ts - T0) * e^(-t/tau), up to the Euler step error
+void startPlantCheck() {
+    initPlant(PLANT_CHECK_SECONDS);
+    simTarget = 0;
+    for (int i = 0; i < 16; i++) simDuty[i] = 1.0;
+    plantMode = PLANT_CHECK;
+}
+
+void stopPlantSim() {
+    plantMode = PLANT_IDLE;
+}
+
+// The controller's own PID law, on the simulator's state; lastUpdate is set
+// one control period back so the law sees the simulated time step
+static void plantControl() {
+    unsigned long period = CONTROL_INTERVAL;
+    for (int i = 0; i < 16; i++) {
+        unsigned long lastUpdate = millis() - period;
+        simDuty[i] = computePID(simKp, simKi, simKd, simIntegral[i], simLastError[i],
+                                lastUpdate, simTemp[i], simTarget);
+    }
+}
+
+static void plantStep(float coupling) {
+    // Conduction from the temperatures at the start of the step
+    for (int i = 0; i < 16; i++) simFlow[i] = 0;
+    for (int r = 0; r < FIELD_SENSOR_ROWS; r++) {
+        for (int c = 0; c < FIELD_SENSOR_COLS; c++) {
+            int i = r * FIELD_SENSOR_COLS + c;
+            if (c + 1 < FIELD_SENSOR_COLS) {
+                float d = simTemp[i + 1] - simTemp[i];
+                simFlow[i] += d;
+                simFlow[i + 1] -= d;
+            }
+            if (r + 1 < FIELD_SENSOR_ROWS) {
+                float d = simTemp[i + FIELD_SENSOR_COLS] - simTemp[i];
+                simFlow[i] += d;
+                simFlow[i + FIELD_SENSOR_COLS] -= d;
+            }
+        }
+    }
+    float loss = 1.0 / modelTau;
+    float ambient = ambientTemperature();
+    for (int i = 0; i < 16; i++) {
+        simTemp[i] += PLANT_DT_S * (modelHeatRate * simDuty[i] -
+                                    (simTemp[i] - ambient) * loss +
+                                    coupling * simFlow[i]);
+    }
+}
+
+static void plantObserve() {
+    for (int i = 0; i < 16; i++) {
+        if (simTemp[i] > simPeak) simPeak = simTemp[i];
+        if (plantMode == PLANT_RUN) {
+            if (simReach[i] < 0 && simTemp[i] >= simTarget - PLANT_REACH_BAND) simReach[i] = simElapsed;
+        } else {
+            float steady = ambientTemperature() + modelHeatRate * modelTau;
+            float exact = steady - (steady - simStart[i]) * exp(-simElapsed / modelTau);
+            float err = fabs(simTemp[i] - exact);
+            if (err > checkError) checkError = err;
+        }
+    }
+}
+
+void updatePlantSim() {
+    if (plantMode == PLANT_IDLE) return;
+    if (modelTau <= 0) {
+        Serial.println(F("SIM aborted: model tau must be > 0."));
+        plantMode = PLANT_IDLE;
+        return;
+    }
+
+    long controlEvery = CONTROL_INTERVAL / 1000;
+    unsigned long begin = micros();
+    for (int n = 0; n < PLANT_STEPS_PER_PASS && simElapsed < simSeconds; n++) {
+        if (plantMode == PLANT_RUN && simElapsed % controlEvery == 0) plantControl();
+        plantStep(plantMode == PLANT_RUN ? plantCoupling : 0);
+        simElapsed += PLANT_DT_S;
+        plantObserve();
+    }
+    simMicros += micros() - begin;
+
+    if (simElapsed >= simSeconds) {
+        printPlantSim();
+        plantMode = PLANT_IDLE;
+    }
+}
+
+// SIM s=<sim s> reach=<slowest s, -1 = not reached> overshoot=<°C> spread=<°C> rate=<sim s per s>
+// SIMCHECK s=<sim s> err=<°C> rate=<sim s per s>
+void printPlantSim() {
+    if (simSeconds == 0) {
+        Serial.println(F("SIM idle"));
+        return;
+    }
+    float rate = simMicros > 0 ? simElapsed * 1000000.0 / simMicros : 0;
+    if (simTarget == 0) {
+        Serial.print(F("SIMCHECK s="));
+        Serial.print(simElapsed);
+        Serial.print(F(" err="));
+        Serial.print(checkError, 3);
+        Serial.print(F(" rate="));
+        Serial.println(rate, 0);
+        return;
+    }
+
+    long slowest = 0;
+    float coldest = simTemp[0], hottest = simTemp[0];
+    for (int i = 0; i < 16; i++) {
+        if (simReach[i] < 0) slowest = -1;
+        else if (slowest >= 0 && simReach[i] > slowest) slowest = simReach[i];
+        if (simTemp[i] < coldest) coldest = simTemp[i];
+        if (simTemp[i] > hottest) hottest = simTemp[i];
+    }
+    Serial.print(F("SIM s="));
+    Serial.print(simElapsed);
+    Serial.print(F(" reach="));
+    Serial.print(slowest);
+    Serial.print(F(" overshoot="));
+    Serial.print(max(simPeak - simTarget, 0.0));
+    Serial.print(F(" spread="));
+    Serial.print(hottest - coldest);
+    Serial.print(F(" rate="));
+    Serial.println(rate, 0);
+}
@@ -0,0 +1,29 @@
+#ifndef PLANT_H
+#define PLANT_H
+
+#include <Arduino.h>
+
+// Simulação do modelo da cama no próprio controlador.
+// All 16 segments are advanced together each step: first-order heating and
+// loss from the MODEL parameters plus conduction to the 4-neighbours, with
+// the live PID law (or trial gains) closing the loop. It runs a few steps per
+// loop pass and never touches the relays.
+
+#define PLANT_DT_S 1             // Simulated seconds per step (whole seconds)
+#define PLANT_STEPS_PER_PASS 5   // Steps advanced per loop pass
+#define PLANT_REACH_BAND 1.0     // °C below target that counts as reached
+#define PLANT_DEFAULT_SECONDS 900
+#define PLANT_CHECK_SECONDS 600
+#define PLANT_MAX_SECONDS 7200
+
+// Conduction between adjacent segments (1/s per °C of difference)
+extern float plantCoupling;
+
+// Funções do simulador
+bool startPlantSim(float target, long seconds, float kp, float ki, float kd);
+void startPlantCheck();
+void stopPlantSim();
+void updatePlantSim();
+void printPlantSim();
+
+#endif
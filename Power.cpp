@@ -0,0 +1,87 @@
+#include "Power.h"
+#include "MY-HeatBed_Controller.h" // Para acessar relayPins e activeSegments
+#include "ControlStrategy.h" // Para acessar segmentDuty e RELAY_WINDOW_MS
+#include "SerialCommands.h" // Para acessar thermalSafetyTriggered
+#include "Energy.h"
+#include "Mains.h"
+
+float powerCapWatts = 0;
+float requestedDuty[16] = {0};
+unsigned long relaySwitches[16] = {0};
+
+static float capFactor = 1.0;
+static uint16_t relayState = 0; // Bit i set while relay i is on
+static uint16_t staggerStart[16]; // On-time start of each segment in the current window (ms)
+static unsigned long staggerWindow = 0; // Window the offsets were latched for, + 1 (0 = none yet)
+
+float requestedPower() {
+    float duty = 0;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (activeSegments[i]) duty += requestedDuty[i];
+    }
+    float power = duty * heaterWatts;
+    if (mainsCompensation) {
+        power = power * MAINS_FACTOR_ONE / mainsFactorQ12; // Same basis as segmentPower()
+    }
+    return power;
+}
+
+float appliedPower() {
+    float power = 0;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        power += segmentPower(i);
+    }
+    return power;
+}
+
+// Relay on-time per window (in ms) that a control loop duty ends up as,
+// through the same mains compensation and power cap as the live relays
+unsigned long relayOnTime(float duty) {
+    return compensateDuty(duty) * capFactor * RELAY_WINDOW_MS;
+}
+
+// Called every loop pass and whenever a control loop applies a new duty
+void updateRelayOutputs() {
+    float requested = requestedPower();
+    capFactor = (powerCapWatts > 0 && requested > powerCapWatts) ? powerCapWatts / requested : 1.0;
+
+    unsigned long now = millis();
+    unsigned long phase = now % RELAY_WINDOW_MS;
+    unsigned long window = now / RELAY_WINDOW_MS + 1;
+    bool newWindow = window != staggerWindow;
+    staggerWindow = window;
+
+    unsigned long start = 0; // Where this segment's on-time begins in the window
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        float duty = (activeSegments[i] && !thermalSafetyTriggered) ? requestedDuty[i] * capFactor : 0;
+        segmentDuty[i] = duty;
+
+        // Each segment's start is placed after the previous one once per
+        // window and then held, so a duty change earlier in the chain does
+        // not move the later on-times mid-window (extra relay clicks)
+        unsigned long onTime = duty * RELAY_WINDOW_MS;
+        if (newWindow) staggerStart[i] = start;
+        unsigned long offset = (phase + RELAY_WINDOW_MS - staggerStart[i]) % RELAY_WINDOW_MS;
+        bool relayOn = offset < onTime;
+        digitalWrite(relayPins[i], relayOn ? LOW : HIGH); // Relays are active LOW
+        if (relayOn && !bitRead(relayState, i)) {
+            relaySwitches[i]++;
+            bitSet(relayState, i);
+        } else if (!relayOn) {
+            bitClear(relayState, i);
+        }
+        start = (start + onTime) % RELAY_WINDOW_MS;
+    }
+}
+
+// POWER req=<W> cap=<W> out=<W> factor=<0..1>
+void printPowerStatus() {
+    Serial.print(F("POWER req="));
+    Serial.print(requestedPower(), 1);
+    Serial.print(F(" cap="));
+    Serial.print(powerCapWatts, 1);
+    Serial.print(F(" out="));
+    Serial.print(appliedPower(), 1);
+    Serial.print(F(" factor="));
+    Serial.println(capFactor, 3);
+}
@@ -0,0 +1,23 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+// Limite de potência por controlador e acionamento escalonado dos relés.
+// The control loops request duties; the relays are driven every loop pass
+// from the requested duties, scaled down to the power cap, with the on-time
+// of each segment placed after the previous one in the relay window so the
+// instantaneous load stays close to the average.
+
+extern float powerCapWatts;     // 0 = no cap
+extern float requestedDuty[16]; // Duty asked for by the control loops
+extern unsigned long relaySwitches[16]; // Relay off->on transitions since power-up
+
+// Funções de potência
+void updateRelayOutputs();
+float requestedPower();
+float appliedPower();
+unsigned long relayOnTime(float duty);
+void printPowerStatus();
+
+#endif
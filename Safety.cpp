@@ -1,26 +1,259 @@
 #include "Safety.h"
 #include "Pins.h" // Para acessar as funções deactivateAllSegments
 #include "TemperatureControl.h" // Para acessar as funções de temperatura
+#include "Telemetry.h"
+#include "ControlStrategy.h" // Para acessar segmentDuty
+#include "Setpoints.h"
+#include "Ambient.h"
+#include "Job.h"
+#include "Field.h" // Para acessar FIELD_SENSOR_COLS/ROWS
 
 extern bool thermalSafetyTriggered; // Declare as external
 
+unsigned long duetLinkTimeout = 0;
+unsigned long garbageCommands = 0;
+static unsigned long lastDuetActivity = 0;
+
+// Runaway watch per segment: reference temperature and when it was taken
+static float runawayRefTemp[16] = {0};
+static unsigned long runawayRefTime[16] = {0};
+// Sensor faults already reported, so an idle segment alerts once per fault
+static uint16_t sensorFaultSeen = 0;
+
+// Injected fault, at most one at a time
+static int injectedType = FAULT_NONE;
+static int injectedSegment = -1;
+static float injectedValue = 0;
+static unsigned long injectedAt = 0;
+static bool injectedReported = false;
+
+const __FlashStringHelper *faultName(int type) {
+    switch (type) {
+        case FAULT_OPEN: return F("OPEN");
+        case FAULT_SHORT: return F("SHORT");
+        case FAULT_OVERTEMP: return F("OVERTEMP");
+        case FAULT_RUNAWAY: return F("RUNAWAY");
+        case FAULT_LINK: return F("LINK");
+        default: return F("NONE");
+    }
+}
+
+static unsigned long faultBudget(int type) {
+    switch (type) {
+        case FAULT_OPEN:
+        case FAULT_SHORT: return FAULT_BUDGET_SENSOR_MS;
+        case FAULT_LINK: return duetLinkTimeout + FAULT_BUDGET_LINK_MS;
+        case FAULT_RUNAWAY: return FAULT_BUDGET_RUNAWAY_MS;
+        default: return FAULT_BUDGET_OVERTEMP_MS;
+    }
+}
+
+// Called once the relays are off. Reports latency against the budget if the
+// fault was injected.
+static void faultHandled(int type, int segment) {
+    emitEvent(faultName(type), segment + 1, 0);
+    noteJobFault();
+
+    // Open and shorted thermistors look the same once converted
+    bool sensorFault = (type == FAULT_OPEN || type == FAULT_SHORT);
+    bool matches = (injectedType == type) ||
+                   (sensorFault && (injectedType == FAULT_OPEN || injectedType == FAULT_SHORT));
+    if (injectedType == FAULT_NONE || injectedReported || !matches) return;
+    if (injectedType != FAULT_LINK && injectedSegment != segment) return;
+
+    unsigned long latency = millis() - injectedAt;
+    unsigned long budget = faultBudget(injectedType);
+    Serial.print(F("FAULT "));
+    Serial.print(faultName(injectedType));
+    Serial.print(F(" latency_ms="));
+    Serial.print(latency);
+    Serial.print(F(" budget_ms="));
+    Serial.print(budget);
+    Serial.println(latency <= budget ? F(" PASS") : F(" FAIL"));
+
+    // The link fault clears itself; the others stay applied until FAULT CLEAR
+    injectedReported = true;
+    if (injectedType == FAULT_LINK) {
+        clearInjectedFaults();
+    }
+}
+
+static void latchSafety(int type, int segment, float temp) {
+    thermalSafetyTriggered = true;
+    deactivateAllSegments(); // Desativa todos os segmentos
+    Serial.print(F("ALERT: "));
+    Serial.print(type == FAULT_RUNAWAY ? F("Thermal runaway") : F("Critical temperature"));
+    Serial.print(F(" detected in segment "));
+    Serial.print(segment + 1);
+    Serial.print(F(" ("));
+    Serial.print(temp);
+    Serial.println(F("°C). All segments deactivated!"));
+    emitEvent(F("SAFETY"), segment + 1, temp);
+    faultHandled(type, segment);
+}
+
+// Runs every SAFETY_INTERVAL: relay-off must not wait for the control interval
+// Hottest readable segment next to segment i on the sensor grid, -999 if none
+static float hottestNeighbour(const float *temps, int i) {
+    int r = i / FIELD_SENSOR_COLS;
+    int c = i % FIELD_SENSOR_COLS;
+    float hottest = -999.0;
+    if (c > 0) hottest = max(hottest, temps[i - 1]);
+    if (c + 1 < FIELD_SENSOR_COLS) hottest = max(hottest, temps[i + 1]);
+    if (r > 0) hottest = max(hottest, temps[i - FIELD_SENSOR_COLS]);
+    if (r + 1 < FIELD_SENSOR_ROWS) hottest = max(hottest, temps[i + FIELD_SENSOR_COLS]);
+    return hottest;
+}
+
 void checkThermalSafety() {
+    static unsigned long lastCheck = 0;
+    unsigned long now = millis();
+    if (now - lastCheck < SAFETY_INTERVAL) return;
+    lastCheck = now;
+
+    // All readings first: the runaway check compares each segment with its neighbours
+    float temps[16];
+    for (int i = 0; i < 16; i++) {
+        temps[i] = readTemperature(tempSensors[i]);
+        if (temps[i] > SAFETY_TEMP_MAX) {
+            latchSafety(FAULT_OVERTEMP, i, temps[i]);
+            return;
+        }
+    }
+
+    for (int i = 0; i < 16; i++) {
+        float temp = temps[i];
+
+        // Every segment is watched, active or not: a welded relay heats a
+        // deactivated segment just the same
+
+        // Failed sensor: this segment cannot be controlled, switch it off
+        if (temp == -999.0) {
+            if (activeSegments[i]) {
+                deactivateSegment(i + 1);
+                Serial.print(F("ALERT: Sensor fault in segment "));
+                Serial.print(i + 1);
+                Serial.println(F(". Segment deactivated!"));
+                faultHandled(injectedType == FAULT_SHORT ? FAULT_SHORT : FAULT_OPEN, i);
+            } else if (!bitRead(sensorFaultSeen, i)) {
+                Serial.print(F("ALERT: Sensor fault in inactive segment "));
+                Serial.print(i + 1);
+                Serial.println(F("."));
+                faultHandled(injectedType == FAULT_SHORT ? FAULT_SHORT : FAULT_OPEN, i);
+            }
+            bitSet(sensorFaultSeen, i);
+            runawayRefTime[i] = 0;
+            continue;
+        }
+        bitClear(sensorFaultSeen, i);
+
+        // A warm chamber lifts an idle bed towards ambient, and heated
+        // neighbours lift an unheated or lower-set segment by conduction:
+        // only a rise above the setpoint, the ambient and the hottest
+        // neighbour counts
+        float reference = max(segmentSetpoint[i], ambientTemperature());
+        reference = max(reference, hottestNeighbour(temps, i));
+        if (segmentDuty[i] == 0 && temp > reference + RUNAWAY_MARGIN) {
+            if (runawayRefTime[i] == 0 || temp < runawayRefTemp[i]) {
+                runawayRefTemp[i] = temp;
+                runawayRefTime[i] = now;
+            } else if (temp - runawayRefTemp[i] >= RUNAWAY_RISE) {
+                runawayRefTime[i] = 0;
+                latchSafety(FAULT_RUNAWAY, i, temp);
+                return;
+            } else if (now - runawayRefTime[i] > RUNAWAY_WINDOW) {
+                runawayRefTemp[i] = temp; // Cooling or flat: restart the window
+                runawayRefTime[i] = now;
+            }
+        } else {
+            runawayRefTime[i] = 0;
+        }
+    }
+
+    // Duet link watchdog: heating only while the Duet is talking to us
+    bool linkLost = (injectedType == FAULT_LINK) ||
+                    (duetLinkTimeout > 0 && now - lastDuetActivity > duetLinkTimeout);
+    if (linkLost) {
+        bool anyActive = false;
+        for (int i = 0; i < 16; i++) {
+            if (activeSegments[i]) anyActive = true;
+        }
+        if (anyActive) {
+            deactivateAllSegments();
+            Serial.println(F("ALERT: Duet link lost. All segments deactivated!"));
+            faultHandled(FAULT_LINK, -1);
+        }
+    }
+}
+
+// Refused while any sensor is still above the limit: the latch would trip
+// again on the next check, after the relays had a chance to switch on
+bool resetThermalSafety() {
     for (int i = 0; i < 16; i++) {
-        float temp = readTemperature(tempSensors[i]);
+        float temp = sampleTemperature(i); // Fresh reading: the cache may predate a new overheat
         if (temp > SAFETY_TEMP_MAX) {
-            thermalSafetyTriggered = true;
-            deactivateAllSegments(); // Desativa todos os segmentos
-            Serial.print("ALERT: Critical temperature detected in segment ");
+            Serial.print(F("Error: Segment "));
             Serial.print(i + 1);
-            Serial.print(" (");
+            Serial.print(F(" still above the safety limit ("));
             Serial.print(temp);
-            Serial.println("°C). All segments deactivated!");
-            break;
+            Serial.println(F("°C). Reset refused."));
+            return false;
         }
     }
-}
 
-void resetThermalSafety() {
     thermalSafetyTriggered = false;
-    Serial.println("Thermal safety state reset. System ready for use.");
+    Serial.println(F("Thermal safety state reset. System ready for use."));
+    emitEvent(F("SAFETY_RESET"), 0, 0);
+    return true;
+}
+
+void noteDuetActivity() {
+    lastDuetActivity = millis();
+}
+
+void injectFault(int type, int segment, float value) {
+    injectedType = type;
+    injectedSegment = segment;
+    injectedValue = value;
+    injectedAt = millis();
+    injectedReported = false;
+}
+
+void clearInjectedFaults() {
+    injectedType = FAULT_NONE;
+    injectedSegment = -1;
+}
+
+// Hooks in readTemperature
+int injectedAdc(int segment, int analogValue) {
+    if (segment != injectedSegment) return analogValue;
+    if (injectedType == FAULT_OPEN) return 1023;
+    if (injectedType == FAULT_SHORT) return 0;
+    return analogValue;
+}
+
+float injectedTemperature(int segment, float temperature) {
+    if (segment != injectedSegment) return temperature;
+    if (injectedType == FAULT_OVERTEMP) return injectedValue;
+    if (injectedType == FAULT_RUNAWAY) {
+        // Rises at injectedValue °C/s from the moment of injection
+        return temperature + injectedValue * (millis() - injectedAt) / 1000.0;
+    }
+    return temperature;
+}
+
+void printFaultStatus() {
+    Serial.print(F("Injected fault: "));
+    Serial.print(faultName(injectedType));
+    if (injectedType != FAULT_NONE && injectedType != FAULT_LINK) {
+        Serial.print(F(" (segment "));
+        Serial.print(injectedSegment + 1);
+        Serial.print(F(")"));
+    }
+    Serial.println();
+    Serial.print(F("Duet link timeout: "));
+    Serial.print(duetLinkTimeout);
+    Serial.println(F(" ms"));
+    Serial.print(F("Unrecognized commands: "));
+    Serial.println(garbageCommands);
 }
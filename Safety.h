@@ -9,8 +9,46 @@ extern bool thermalSafetyTriggered;
 // Constante para temperatura máxima segura
 #define SAFETY_TEMP_MAX 120.0
 
+// Safety checks run this often, independently of the control interval (in ms)
+#define SAFETY_INTERVAL 100
+
+// Runaway: segment held off but still rising above its setpoint
+#define RUNAWAY_MARGIN 10.0   // °C above setpoint before watching for a rise
+#define RUNAWAY_RISE 2.0      // °C rise that confirms a runaway
+#define RUNAWAY_WINDOW 30000  // Window for the rise (in ms)
+
+// Maximum time from fault injection to relay-off (in ms)
+#define FAULT_BUDGET_SENSOR_MS 2000
+#define FAULT_BUDGET_OVERTEMP_MS 2000
+#define FAULT_BUDGET_LINK_MS 1000 // Added to the configured link timeout
+#define FAULT_BUDGET_RUNAWAY_MS RUNAWAY_WINDOW
+
+// Fault classes, for injection and reporting
+enum FaultType {
+    FAULT_NONE = 0,
+    FAULT_OPEN,     // Open thermistor (ADC at full scale)
+    FAULT_SHORT,    // Shorted thermistor (ADC at zero)
+    FAULT_OVERTEMP, // Reading above SAFETY_TEMP_MAX
+    FAULT_RUNAWAY,  // Rising while held off (e.g. stuck relay)
+    FAULT_LINK      // No line from the Duet within duetLinkTimeout
+};
+
+// Duet link watchdog (in ms, 0 = disabled)
+extern unsigned long duetLinkTimeout;
+// Lines rejected as unrecognized on either link
+extern unsigned long garbageCommands;
+
 // Funções relacionadas à segurança térmica
 void checkThermalSafety();
-void resetThermalSafety();
+bool resetThermalSafety();
+void noteDuetActivity();
+
+// Injeção de falhas (só empurra o sistema no sentido de desligar)
+void injectFault(int type, int segment, float value);
+void clearInjectedFaults();
+int injectedAdc(int segment, int analogValue);
+float injectedTemperature(int segment, float temperature);
+const __FlashStringHelper *faultName(int type);
+void printFaultStatus();
 
 #endif
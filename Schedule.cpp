@@ -0,0 +1,124 @@
+#include "Schedule.h"
+#include "MY-HeatBed_Controller.h" // Para acessar CONTROL_INTERVAL e NUM_SEGMENTS
+#include "ControlStrategy.h" // Para acessar controlSegment
+
+// Every segment starts on the former single loop period
+uint16_t segmentPeriod[16] = {
+    CONTROL_INTERVAL, CONTROL_INTERVAL, CONTROL_INTERVAL, CONTROL_INTERVAL,
+    CONTROL_INTERVAL, CONTROL_INTERVAL, CONTROL_INTERVAL, CONTROL_INTERVAL,
+    CONTROL_INTERVAL, CONTROL_INTERVAL, CONTROL_INTERVAL, CONTROL_INTERVAL,
+    CONTROL_INTERVAL, CONTROL_INTERVAL, CONTROL_INTERVAL, CONTROL_INTERVAL
+};
+
+struct RateGroup {
+    uint16_t period;          // ms
+    uint16_t mask;            // Bit i set: segment i belongs to the group
+    unsigned long lastRun;
+    unsigned long runs;
+    unsigned long totalMicros;
+    unsigned long maxMicros;
+};
+
+static RateGroup groups[16];
+static uint8_t groupCount = 0;
+static bool scheduleDirty = true;
+static unsigned long statsStart = 0;
+
+// Groups sorted by period, shortest (highest priority) first
+static void rebuildSchedule() {
+    groupCount = 0;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        int g = 0;
+        while (g < groupCount && groups[g].period < segmentPeriod[i]) g++;
+        if (g == groupCount || groups[g].period != segmentPeriod[i]) {
+            for (int k = groupCount; k > g; k--) {
+                groups[k] = groups[k - 1];
+            }
+            groups[g].period = segmentPeriod[i];
+            groups[g].mask = 0;
+            groups[g].lastRun = 0;
+            groupCount++;
+        }
+        groups[g].mask |= (1U << i);
+    }
+    resetScheduleStats();
+    scheduleDirty = false;
+}
+
+bool setSegmentPeriod(int segment, long periodMs) {
+    // Round to the minor cycle
+    periodMs = ((periodMs + SCHEDULE_MINOR_MS / 2) / SCHEDULE_MINOR_MS) * SCHEDULE_MINOR_MS;
+    if (periodMs < SCHEDULE_MINOR_MS || periodMs > SCHEDULE_MAX_PERIOD) return false;
+    segmentPeriod[segment] = periodMs;
+    scheduleDirty = true;
+    return true;
+}
+
+// Sample at about a twentieth of the segment's time constant
+bool setSegmentPeriodFromTau(int segment, float tauSeconds) {
+    if (tauSeconds <= 0) return false;
+    long periodMs = tauSeconds * 1000.0 / SCHEDULE_TAU_DIVISOR;
+    periodMs = constrain(periodMs, (long)SCHEDULE_MINOR_MS, (long)SCHEDULE_MAX_PERIOD);
+    return setSegmentPeriod(segment, periodMs);
+}
+
+// Called once per minor cycle
+void runControlSchedule(unsigned long now) {
+    if (scheduleDirty) rebuildSchedule();
+
+    for (int g = 0; g < groupCount; g++) {
+        RateGroup &group = groups[g];
+        if (group.runs > 0 && now - group.lastRun < group.period) continue;
+        group.lastRun = now;
+
+        unsigned long startMicros = micros();
+        for (int i = 0; i < NUM_SEGMENTS; i++) {
+            if (group.mask & (1U << i)) controlSegment(i);
+        }
+        unsigned long elapsed = micros() - startMicros;
+
+        group.runs++;
+        group.totalMicros += elapsed;
+        if (elapsed > group.maxMicros) group.maxMicros = elapsed;
+    }
+}
+
+void resetScheduleStats() {
+    for (int g = 0; g < groupCount; g++) {
+        groups[g].runs = 0;
+        groups[g].totalMicros = 0;
+        groups[g].maxMicros = 0;
+    }
+    statsStart = millis();
+}
+
+// One line per rate group; CPU is the share of wall time spent in the group
+void printSchedule() {
+    if (scheduleDirty) rebuildSchedule();
+    unsigned long window = millis() - statsStart;
+
+    Serial.print(F("Minor cycle: "));
+    Serial.print(SCHEDULE_MINOR_MS);
+    Serial.println(F(" ms"));
+    for (int g = 0; g < groupCount; g++) {
+        RateGroup &group = groups[g];
+        Serial.print(F("Period "));
+        Serial.print(group.period);
+        Serial.print(F(" ms | Segments:"));
+        for (int i = 0; i < NUM_SEGMENTS; i++) {
+            if (group.mask & (1U << i)) {
+                Serial.print(' ');
+                Serial.print(i + 1);
+            }
+        }
+        Serial.print(F(" | Runs: "));
+        Serial.print(group.runs);
+        Serial.print(F(" | Avg: "));
+        Serial.print(group.runs > 0 ? group.totalMicros / group.runs : 0);
+        Serial.print(F(" us | Max: "));
+        Serial.print(group.maxMicros);
+        Serial.print(F(" us | CPU: "));
+        Serial.print(window > 0 ? group.totalMicros / (window * 10.0) : 0.0, 2);
+        Serial.println(F("%"));
+    }
+}
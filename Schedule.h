@@ -0,0 +1,23 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <Arduino.h>
+
+// Escalonamento multi-taxa: cada segmento tem o seu período de controlo.
+// Segments sharing a period form a rate group; groups run shortest period
+// first (rate-monotonic) inside each minor cycle.
+
+#define SCHEDULE_MINOR_MS 500       // Minor cycle; every period is a multiple of it
+#define SCHEDULE_MAX_PERIOD 60000   // Longest allowed segment period (ms)
+#define SCHEDULE_TAU_DIVISOR 20     // Period derived from a time constant: tau / 20
+
+extern uint16_t segmentPeriod[16]; // Control period per segment (ms)
+
+// Funções de escalonamento
+bool setSegmentPeriod(int segment, long periodMs);
+bool setSegmentPeriodFromTau(int segment, float tauSeconds);
+void runControlSchedule(unsigned long now);
+void resetScheduleStats();
+void printSchedule();
+
+#endif
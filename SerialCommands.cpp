@@ -3,177 +3,854 @@
 #include "Debug.h"
 #include "Safety.h"
 #include "TemperatureControl.h"
+#include "Telemetry.h"
+#include "Shadow.h"
+#include "ControlStrategy.h"
+#include "Calibration.h"
+#include "Field.h"
+#include "StateDump.h"
+#include "Setpoints.h"
+#include "Mains.h"
+#include "Energy.h"
+#include "KeepWarm.h"
+#include "Trajectory.h"
+#include "Schedule.h"
+#include "Envelope.h"
+#include "Link.h"
+#include "Config.h"
+#include "Macro.h"
+#include "Power.h"
+#include "Plant.h"
+#include "Ambient.h"
+#include "Job.h"
+#include "MY-HeatBed_Controller.h" // Para acessar a faixa PWM
 
 // Define the external variables
 bool debugMode = false;
 bool thermalSafetyTriggered = false;
 
+// Keywords whose hex blob is left in the port for readHexRecord()
+static const char blobKeywords[][15] PROGMEM = {"STATE LOAD ", "CONFIG IMPORT "};
+
+// One line from the port, like readStringUntil('\n') but bounded: false
+// (and an empty line) if it exceeds COMMAND_MAX_LEN. A blob command stops
+// right after its keyword, trailing space included, with the hex unread.
+bool readCommandLine(Stream &port, String &line) {
+    line = "";
+    line.reserve(COMMAND_MAX_LEN);
+    bool tooLong = false;
+    uint8_t c;
+    while (port.readBytes(&c, 1) == 1 && c != '\n') {
+        if (tooLong) continue;
+        if (line.length() >= COMMAND_MAX_LEN) {
+            tooLong = true;
+            continue;
+        }
+        line += (char)c;
+        if (c == ' ' && (strcmp_P(line.c_str(), blobKeywords[0]) == 0 || strcmp_P(line.c_str(), blobKeywords[1]) == 0)) return true;
+    }
+    if (tooLong) {
+        line = "";
+        return false;
+    }
+    line.trim();
+    return true;
+}
+
+// STATE LOAD / CONFIG IMPORT, with the blob read from the same port
+static bool processBlobCommand(Stream &port, const String &command) {
+    if (strcmp_P(command.c_str(), blobKeywords[0]) == 0) {
+        if (loadState(port)) {
+            Serial.println(F("State loaded."));
+        }
+    } else if (strcmp_P(command.c_str(), blobKeywords[1]) == 0) {
+        if (importConfig(port)) {
+            Serial.println(F("Configuration imported."));
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
 void processSerialCommands() {
     if (Serial.available()) {
-        String command = Serial.readStringUntil('\n');
-        command.trim();
+        String command;
+        bool fits = readCommandLine(Serial, command);
+        if (!fits) {
+            garbageCommands++;
+            noteLinkGarbage(LINK_USB);
+            Serial.println(F("Error: Command too long."));
+            return;
+        }
 
-        Serial.print("Received command: \"");
+        Serial.print(F("Received command: \""));
         Serial.print(command);
-        Serial.println("\"");
+        Serial.println(F("\""));
 
-        if (command == "DEBUG ON") {
+        if (processBlobCommand(Serial, command)) {
+            // Done
+        } else if (command == "DEBUG ON") {
             debugMode = true;
-            Serial.println("Debug mode enabled.");
+            Serial.println(F("Debug mode enabled."));
         } else if (command == "DEBUG OFF") {
             debugMode = false;
-            Serial.println("Debug mode disabled.");
+            Serial.println(F("Debug mode disabled."));
         } else if (command == "STATUS") {
             printSystemStatus();
         } else if (command.startsWith("SET_PWM_RANGE")) {
-            int minPWM = command.substring(14, command.indexOf(" ", 14)).toInt();
-            int maxPWM = command.substring(command.indexOf(" ", 14) + 1, command.lastIndexOf(" ")).toInt();
-            float minTemp = command.substring(command.lastIndexOf(" ") + 1, command.lastIndexOf(" ", command.lastIndexOf(" ") - 1)).toFloat();
-            float maxTemp = command.substring(command.lastIndexOf(" ") + 1).toFloat();
-
-            configurePWMRange(minPWM, maxPWM, minTemp, maxTemp);
+            if (commandArg(command, 4).length() == 0) {
+                Serial.println(F("Error: Usage SET_PWM_RANGE <minPWM> <maxPWM> <minTemp> <maxTemp>."));
+            } else {
+                configurePWMRange(commandArg(command, 1).toInt(), commandArg(command, 2).toInt(),
+                                  commandArg(command, 3).toFloat(), commandArg(command, 4).toFloat());
+            }
         } else if (command == "ON ALL") {
             if (!thermalSafetyTriggered) {
                 activateAllSegments();
-                Serial.println("All segments activated.");
+                Serial.println(F("All segments activated."));
             } else {
-                Serial.println("Error: System in thermal safety state. Reset before continuing.");
+                Serial.println(F("Error: System in thermal safety state. Reset before continuing."));
             }
         } else if (command == "OFF ALL") {
             deactivateAllSegments();
-            Serial.println("All segments deactivated.");
+            Serial.println(F("All segments deactivated."));
         } else if (command.startsWith("ON")) {
             int segmentNumber = command.substring(3).toInt();
             if (segmentNumber >= 1 && segmentNumber <= 16) {
                 if (!thermalSafetyTriggered) {
                     activateSegment(segmentNumber);
-                    Serial.print("Segment ");
+                    Serial.print(F("Segment "));
                     Serial.print(segmentNumber);
-                    Serial.println(" activated.");
+                    Serial.println(F(" activated."));
                 } else {
-                    Serial.println("Error: System in thermal safety state. Reset before continuing.");
+                    Serial.println(F("Error: System in thermal safety state. Reset before continuing."));
                 }
             } else {
-                Serial.println("Error: Invalid segment number. Use HELP to see commands.");
+                Serial.println(F("Error: Invalid segment number. Use HELP to see commands."));
             }
         } else if (command.startsWith("OFF")) {
             int segmentNumber = command.substring(4).toInt();
             if (segmentNumber >= 1 && segmentNumber <= 16) {
                 deactivateSegment(segmentNumber);
-                Serial.print("Segment ");
+                Serial.print(F("Segment "));
                 Serial.print(segmentNumber);
-                Serial.println(" deactivated.");
+                Serial.println(F(" deactivated."));
             } else {
-                Serial.println("Error: Invalid segment number. Use HELP to see commands.");
+                Serial.println(F("Error: Invalid segment number. Use HELP to see commands."));
             }
         } else if (command == "HELP") {
             printHelp();
         } else if (command == "RESET_SAFETY") {
             resetThermalSafety();
-        } else {
-            Serial.println("Error: Unrecognized command. Use HELP to see commands.");
+        } else if (command == "BAUD" || command.startsWith("BAUD ")) {
+            processBaudCommand(LINK_USB, command);
+        } else if (!processExtendedCommand(command)) {
+            garbageCommands++;
+            noteLinkGarbage(LINK_USB);
+            Serial.println(F("Error: Unrecognized command. Use HELP to see commands."));
         }
     }
 }
 
 void processExternalCommand(String command) {
+    if (processBlobCommand(Serial1, command)) return; // Before trim(): the keyword ends in a space
     command.trim();
 
     if (command == "ON ALL") {
         if (!thermalSafetyTriggered) {
             activateAllSegments();
-            Serial.println("All segments activated (Duet).");
+            Serial.println(F("All segments activated (Duet)."));
         } else {
-            Serial.println("Error: Thermal safety active (Duet).");
+            Serial.println(F("Error: Thermal safety active (Duet)."));
         }
     } else if (command == "OFF ALL") {
         deactivateAllSegments();
-        Serial.println("All segments deactivated (Duet).");
+        Serial.println(F("All segments deactivated (Duet)."));
     } else if (command.startsWith("ON")) {
         int segmentNumber = command.substring(3).toInt();
         if (segmentNumber >= 1 && segmentNumber <= 16) {
             if (!thermalSafetyTriggered) {
                 activateSegment(segmentNumber);
-                Serial.print("Segment ");
+                Serial.print(F("Segment "));
                 Serial.print(segmentNumber);
-                Serial.println(" activated (Duet).");
+                Serial.println(F(" activated (Duet)."));
             } else {
-                Serial.println("Error: Thermal safety active (Duet).");
+                Serial.println(F("Error: Thermal safety active (Duet)."));
             }
         } else {
-            Serial.println("Error: Invalid segment number (Duet).");
+            Serial.println(F("Error: Invalid segment number (Duet)."));
         }
     } else if (command.startsWith("OFF")) {
         int segmentNumber = command.substring(4).toInt();
         if (segmentNumber >= 1 && segmentNumber <= 16) {
             deactivateSegment(segmentNumber);
-            Serial.print("Segment ");
+            Serial.print(F("Segment "));
             Serial.print(segmentNumber);
-            Serial.println(" deactivated (Duet).");
+            Serial.println(F(" deactivated (Duet)."));
         } else {
-            Serial.println("Error: Invalid segment number (Duet).");
+            Serial.println(F("Error: Invalid segment number (Duet)."));
         }
     } else if (command == "RESET_SAFETY") {
-        resetThermalSafety();
-        Serial.println("Thermal safety state reset (Duet).");
+        if (resetThermalSafety()) {
+            Serial.println(F("Thermal safety state reset (Duet)."));
+        }
     } else if (command == "DEBUG ON") {
         debugMode = true;
-        Serial.println("Debug mode enabled (Duet).");
+        Serial.println(F("Debug mode enabled (Duet)."));
     } else if (command == "DEBUG OFF") {
         debugMode = false;
-        Serial.println("Debug mode disabled (Duet).");
+        Serial.println(F("Debug mode disabled (Duet)."));
     } else if (command == "HELP") {
         printHelp();
     } else if (command == "STATUS") {
         printSystemStatus();
-    } else {
-        Serial.print("Error: Unrecognized command (Duet): ");
+    } else if (command == "BAUD" || command.startsWith("BAUD ")) {
+        processBaudCommand(LINK_DUET, command);
+    } else if (!processExtendedCommand(command)) {
+        garbageCommands++;
+        noteLinkGarbage(LINK_DUET);
+        Serial.print(F("Error: Unrecognized command (Duet): "));
         Serial.println(command);
     }
 }
 
-void printHelp() {
-    Serial.println("Available commands:");
-    Serial.println("  ON ALL              - Activate all segments");
-    Serial.println("  OFF ALL             - Deactivate all segments");
-    Serial.println("  ON <n>              - Activate segment <n> (1-16)");
-    Serial.println("  OFF <n>             - Deactivate segment <n> (1-16)");
-    Serial.println("  SET_PWM_RANGE <minPWM> <maxPWM> <minTemp> <maxTemp> - Configure PWM range");
-    Serial.println("  DEBUG ON            - Enable debug mode");
-    Serial.println("  DEBUG OFF           - Disable debug mode");
-    Serial.println("  STATUS              - Display system status");
-    Serial.println("  HELP                - Display this list of commands");
-    Serial.println("  RESET_SAFETY        - Reset thermal safety state");
+// Returns the n-th (0-based) space-separated token of a command, or "" if absent
+String commandArg(const String &command, int n) {
+    int start = 0;
+    int len = command.length();
+    for (int i = 0; ; i++) {
+        while (start < len && command.charAt(start) == ' ') start++;
+        if (start >= len) return "";
+        int end = command.indexOf(' ', start);
+        if (end < 0) end = len;
+        if (i == n) return command.substring(start, end);
+        start = end;
+    }
 }
 
-void printSystemStatus() {
-    Serial.println("System Status:");
-    // Add more details about the system status here
-    // For example:
-    // Serial.println("Temperature: 25°C");
-    // Serial.println("Heater: ON");
-    // Serial.println("Fan: OFF");
+// Commands shared by the USB and Duet links. Returns false if not recognized.
+bool processExtendedCommand(const String &command) {
+    if (command == "SNAPSHOT") {
+        printSnapshot();
+    } else if (command == "STREAM OFF") {
+        streamInterval = 0;
+        Serial.println(F("Telemetry stream stopped."));
+    } else if (command.startsWith("STREAM ")) {
+        long interval = commandArg(command, 1).toInt();
+        if (interval < STREAM_MIN_INTERVAL) {
+            Serial.println(F("Error: Usage STREAM <ms> (>= 10) or STREAM OFF."));
+        } else {
+            streamInterval = interval;
+            Serial.print(F("Telemetry stream every "));
+            Serial.print(streamInterval);
+            Serial.println(F(" ms."));
+        }
+    } else if (command.startsWith("SET_TEMP ")) {
+        int section = commandArg(command, 1).toInt();
+        String value = commandArg(command, 2);
+        float temp = value.toFloat();
+        if (section < 1 || section > 4 || value.length() == 0) {
+            Serial.println(F("Error: Usage SET_TEMP <section 1-4> <temp>."));
+        } else if (temp < 0 || temp > SAFETY_TEMP_MAX) {
+            Serial.println(F("Error: Setpoint outside safe range."));
+        } else {
+            targetTemp[section - 1] = temp;
+            clearRampQueue(section - 1); // A direct setpoint replaces the queued steps
+            Serial.print(F("Sec "));
+            Serial.print(section);
+            Serial.print(F(" setpoint set to "));
+            Serial.print(temp);
+            Serial.println(F("°C."));
+            emitEvent(F("SETPOINT"), section, temp);
+        }
+    } else if (command.startsWith("SHADOW ON")) {
+        if (commandArg(command, 4).length() == 0) {
+            Serial.println(F("Error: Usage SHADOW ON <kp> <ki> <kd>."));
+        } else {
+            shadowStart(commandArg(command, 2).toFloat(), commandArg(command, 3).toFloat(),
+                        commandArg(command, 4).toFloat());
+            Serial.print(F("Shadow controller enabled (Kp="));
+            Serial.print(shadowKp);
+            Serial.print(F(" Ki="));
+            Serial.print(shadowKi);
+            Serial.print(F(" Kd="));
+            Serial.print(shadowKd);
+            Serial.println(F(")."));
+        }
+    } else if (command == "SHADOW OFF") {
+        shadowStop();
+        Serial.println(F("Shadow controller disabled."));
+    } else if (command == "SHADOW STATS") {
+        printShadowStats();
+    } else if (command == "SHADOW RESET") {
+        shadowResetStats();
+        Serial.println(F("Shadow statistics reset."));
+    } else if (command == "SIM") {
+        printPlantSim();
+    } else if (command == "SIM STOP") {
+        stopPlantSim();
+        Serial.println(F("Simulation stopped."));
+    } else if (command == "SIM CHECK") {
+        startPlantCheck();
+        Serial.println(F("Simulation check started."));
+    } else if (command.startsWith("SIM COUPLING ")) {
+        float coupling = commandArg(command, 2).toFloat();
+        if (coupling < 0) {
+            Serial.println(F("Error: Usage SIM COUPLING <1/s>."));
+        } else {
+            plantCoupling = coupling;
+            Serial.print(F("Simulated segment coupling set to "));
+            Serial.print(plantCoupling, 4);
+            Serial.println(F(" 1/s."));
+        }
+    } else if (command.startsWith("SIM ")) {
+        // SIM <target> [seconds] [kp ki kd]; gains default to the live PID
+        float target = commandArg(command, 1).toFloat();
+        long seconds = commandArg(command, 2).length() ? commandArg(command, 2).toInt() : PLANT_DEFAULT_SECONDS;
+        bool gains = commandArg(command, 5).length() > 0;
+        if (!startPlantSim(target, seconds, gains ? commandArg(command, 3).toFloat() : pidKp,
+                           gains ? commandArg(command, 4).toFloat() : pidKi,
+                           gains ? commandArg(command, 5).toFloat() : pidKd)) {
+            Serial.println(F("Error: Usage SIM <target> [seconds] [kp ki kd] (target above ambient, up to 7200 s)."));
+        } else {
+            Serial.println(F("Simulation started."));
+        }
+    } else if (command == "STRATEGY") {
+        printStrategies();
+    } else if (command == "STRATEGY STATS") {
+        printStrategyStats();
+    } else if (command.startsWith("STRATEGY ")) {
+        int section = commandArg(command, 1).toInt();
+        int strategy = findStrategy(commandArg(command, 2));
+        String duty = commandArg(command, 3);
+        if (section < 1 || section > 4 || strategy < 0) {
+            Serial.println(F("Error: Usage STRATEGY <section 1-4> <HYST|PID|PIDFF|MODEL|MANUAL> [duty%]."));
+        } else {
+            setSectionStrategy(section - 1, strategy);
+            if (strategy == STRATEGY_MANUAL && duty.length() > 0) {
+                manualDuty[section - 1] = constrain(duty.toFloat(), 0.0, 100.0) / 100.0;
+            }
+            Serial.print(F("Sec "));
+            Serial.print(section);
+            Serial.print(F(" strategy set to "));
+            Serial.print(strategyName(strategy));
+            Serial.println(F("."));
+        }
+    } else if (command == "SET_FF" || command.startsWith("SET_FF ")) {
+        if (commandArg(command, 1).length() == 0) {
+            Serial.println(F("Error: Usage SET_FF <gain>."));
+        } else {
+            ffGain = commandArg(command, 1).toFloat();
+            Serial.print(F("Feedforward gain set to "));
+            Serial.print(ffGain, 5);
+            Serial.println(F(" duty/°C."));
+        }
+    } else if (command == "SET_PID" || command.startsWith("SET_PID ")) {
+        if (commandArg(command, 3).length() == 0) {
+            Serial.println(F("Error: Usage SET_PID <kp> <ki> <kd>."));
+        } else {
+            pidKp = commandArg(command, 1).toFloat();
+            pidKi = commandArg(command, 2).toFloat();
+            pidKd = commandArg(command, 3).toFloat();
+            Serial.println(F("PID gains updated."));
+        }
+    } else if (command.startsWith("SET_MODEL ")) {
+        if (commandArg(command, 3).length() == 0) {
+            Serial.println(F("Error: Usage SET_MODEL <heatRate °C/s> <tau s> <horizon s>."));
+        } else {
+            modelHeatRate = commandArg(command, 1).toFloat();
+            modelTau = commandArg(command, 2).toFloat();
+            modelHorizon = commandArg(command, 3).toFloat();
+            Serial.println(F("Plant model parameters updated."));
+        }
+    } else if (command == "CAL") {
+        printCalibration();
+    } else if (command == "CAL START") {
+        calibrationBegin();
+        Serial.println(F("Calibration started."));
+    } else if (command == "CAL ABORT") {
+        calibrationAbort();
+        Serial.println(F("Calibration aborted."));
+    } else if (command.startsWith("CAL IN ")) {
+        if (!calibrationAddInputPoint(commandArg(command, 2).toFloat())) {
+            Serial.println(F("Error: Calibration not started or too many points."));
+        }
+    } else if (command.startsWith("CAL OUT ")) {
+        calibrationDriveOutput(commandArg(command, 2).toInt());
+        Serial.println(F("CAL OUT ready."));
+    } else if (command.startsWith("CAL READ ")) {
+        if (calibrationAddOutputPoint(commandArg(command, 2).toFloat())) {
+            Serial.println(F("CAL READ stored."));
+        } else {
+            Serial.println(F("Error: Calibration not started or too many points."));
+        }
+    } else if (command == "CAL FIT") {
+        if (calibrationFit()) {
+            printCalibration();
+        }
+    } else if (command == "CAL SAVE") {
+        if (saveCalibration()) {
+            Serial.println(F("Calibration saved to EEPROM."));
+        } else {
+            Serial.println(F("Error: No calibration to save (CAL FIT first)."));
+        }
+    } else if (command == "FIELD STATS") {
+        printFieldStats();
+    } else if (command == "FIELD STATS RESET") {
+        resetFieldStats();
+        Serial.println(F("Field statistics reset."));
+    } else if (command.startsWith("FIELD GRID")) {
+        int n = commandArg(command, 2).toInt();
+        printFieldGrid(n > 0 ? n : FIELD_DEFAULT_GRID);
+    } else if (command == "FIELD" || command.startsWith("FIELD ")) {
+        int n = commandArg(command, 1).toInt();
+        printFieldSummary(n > 0 ? n : FIELD_DEFAULT_GRID);
+    } else if (command == "SURFACE") {
+        printSurfaceOffsets();
+    } else if (command == "SURFACE ON" || command == "SURFACE OFF") {
+        surfaceControl = (command == "SURFACE ON");
+        Serial.print(F("Surface temperature control "));
+        Serial.println(surfaceControl ? F("enabled.") : F("disabled."));
+    } else if (command == "SURFACE CLEAR") {
+        for (int i = 0; i < NUM_SEGMENTS; i++) {
+            surfaceOffset[i] = 0;
+            surfaceSlope[i] = 0;
+        }
+        Serial.println(F("Surface offsets cleared."));
+    } else if (command == "SURFACE SAVE") {
+        saveSurfaceOffsets();
+        Serial.println(F("Surface offsets saved to EEPROM."));
+    } else if (command.startsWith("SURFACE ")) {
+        int segmentNumber = commandArg(command, 1).toInt();
+        String offset = commandArg(command, 2);
+        if (segmentNumber < 1 || segmentNumber > 16 || offset.length() == 0) {
+            Serial.println(F("Error: Usage SURFACE <n> <offset> [slope]."));
+        } else {
+            surfaceOffset[segmentNumber - 1] = offset.toFloat();
+            surfaceSlope[segmentNumber - 1] = commandArg(command, 3).toFloat();
+            Serial.print(F("Segment "));
+            Serial.print(segmentNumber);
+            Serial.println(F(" surface offset set."));
+        }
+    } else if (command == "FAULT") {
+        printFaultStatus();
+    } else if (command == "FAULT CLEAR") {
+        clearInjectedFaults();
+        Serial.println(F("Injected faults cleared."));
+    } else if (command.startsWith("FAULT ")) {
+        String type = commandArg(command, 1);
+        int segmentNumber = commandArg(command, 2).toInt();
+        float value = commandArg(command, 3).toFloat();
+        int fault = FAULT_NONE;
+        if (type == "OPEN") fault = FAULT_OPEN;
+        else if (type == "SHORT") fault = FAULT_SHORT;
+        else if (type == "OVERTEMP") fault = FAULT_OVERTEMP;
+        else if (type == "RUNAWAY") fault = FAULT_RUNAWAY;
+        else if (type == "LINK") fault = FAULT_LINK;
+
+        if (fault == FAULT_NONE || (fault != FAULT_LINK && (segmentNumber < 1 || segmentNumber > 16))) {
+            Serial.println(F("Error: Usage FAULT <OPEN|SHORT|OVERTEMP|RUNAWAY> <n> [value], FAULT LINK or FAULT CLEAR."));
+        } else {
+            if (fault == FAULT_OVERTEMP && value <= SAFETY_TEMP_MAX) value = SAFETY_TEMP_MAX + 5;
+            if (fault == FAULT_RUNAWAY && value <= 0) value = 1.0; // °C/s
+            injectFault(fault, segmentNumber - 1, value);
+            Serial.print(F("Fault injected: "));
+            Serial.println(faultName(fault));
+        }
+    } else if (command.startsWith("LINK_TIMEOUT ")) {
+        duetLinkTimeout = commandArg(command, 1).toInt();
+        noteDuetActivity(); // Start counting from now
+        Serial.print(F("Duet link timeout set to "));
+        Serial.print(duetLinkTimeout);
+        Serial.println(F(" ms (0 = disabled)."));
+    } else if (command.startsWith("CAL SET ")) {
+        String which = commandArg(command, 2);
+        int first = (which == "IN") ? 5 : 4; // Index of the offset argument
+        int section = commandArg(command, 3).toInt();
+        if (commandArg(command, first).length() == 0 || (which == "IN" && (section < 1 || section > 4)) ||
+            (which != "IN" && which != "OUT")) {
+            Serial.println(F("Error: Usage CAL SET IN <section 1-4> <slope> <offset> | CAL SET OUT <slope> <offset>."));
+        } else {
+            LinearMap &map = (which == "IN") ? pwmInMap[section - 1] : pwmOutMap;
+            map.slope = commandArg(command, first - 1).toFloat();
+            map.offset = commandArg(command, first).toFloat();
+            pwmCalibrated = true;
+            printCalibration();
+        }
+    } else if (command == "CONFIG EXPORT") {
+        exportConfig();
+    } else if (command == "CONFIG EXPORT SCRIPT") {
+        exportConfigScript();
+    } else if (command == "MACRO" || command == "MACRO LIST") {
+        listMacros();
+    } else if (command.startsWith("MACRO DEFINE ")) {
+        String name = commandArg(command, 2);
+        int stepsStart = command.indexOf(name, 13) + name.length();
+        defineMacro(name, command.substring(stepsStart));
+    } else if (command.startsWith("MACRO SHOW ")) {
+        if (!showMacro(commandArg(command, 2))) {
+            Serial.println(F("Error: Unknown macro."));
+        }
+    } else if (command.startsWith("MACRO DELETE ")) {
+        if (deleteMacro(commandArg(command, 2))) {
+            Serial.println(F("Macro deleted."));
+        } else {
+            Serial.println(F("Error: Unknown macro."));
+        }
+    } else if (command == "MACRO CLEAR") {
+        clearMacros();
+        Serial.println(F("All macros deleted."));
+    } else if (command == "MACRO STOP") {
+        stopMacro();
+    } else if (command.startsWith("RUN ")) {
+        runMacro(command);
+    } else if (command == "POWER") {
+        printPowerStatus();
+    } else if (command.startsWith("POWER CAP ")) {
+        float cap = commandArg(command, 2).toFloat();
+        if (cap < 0) {
+            Serial.println(F("Error: Usage POWER CAP <W> (0 = no cap)."));
+        } else {
+            powerCapWatts = cap;
+            updateRelayOutputs(); // Takes effect now, not at the next control step
+            printPowerStatus();
+        }
+    } else if (command == "STATE DUMP") {
+        dumpState();
+    } else if (command == "STATE LOAD" || command == "CONFIG IMPORT") {
+        // With a blob these never get here (processBlobCommand)
+        Serial.println(F("Error: Usage STATE LOAD <hex> / CONFIG IMPORT <hex>, sent on a serial port."));
+    } else if (command == "SETPOINTS") {
+        printSetpoints();
+    } else if (command.startsWith("SETPOINTS ") || command.startsWith("SETPOINT_OFFSETS ")) {
+        bool offsets = command.startsWith("SETPOINT_OFFSETS ");
+        if (stageSetpoints(commandArg(command, 1), offsets)) {
+            if (!offsets) setpointMode = SETPOINT_SEGMENT;
+            Serial.println(F("Setpoints staged for the next control tick."));
+        } else {
+            Serial.println(F("Error: Expected 16 comma-separated values within the safe range."));
+        }
+    } else if (command.startsWith("SETPOINT_MODE ")) {
+        String mode = commandArg(command, 1);
+        if (mode == "SECTION") setpointMode = SETPOINT_SECTION;
+        else if (mode == "SEGMENT") setpointMode = SETPOINT_SEGMENT;
+        else if (mode == "OFFSET") setpointMode = SETPOINT_OFFSET;
+        else {
+            Serial.println(F("Error: Usage SETPOINT_MODE <SECTION|SEGMENT|OFFSET>."));
+            return true;
+        }
+        Serial.print(F("Setpoint mode set to "));
+        Serial.print(mode);
+        Serial.println(F("."));
+    } else if (command.startsWith("SETPOINT_SOURCE ")) {
+        String source = commandArg(command, 1);
+        if (source == "PWM") setpointSource = SOURCE_PWM;
+        else if (source == "SERIAL") setpointSource = SOURCE_SERIAL;
+        else {
+            Serial.println(F("Error: Usage SETPOINT_SOURCE <SERIAL|PWM>."));
+            return true;
+        }
+        Serial.print(F("Section setpoints now come from "));
+        Serial.print(source);
+        Serial.println(F("."));
+    } else if (command == "MAINS") {
+        printMainsStatus();
+    } else if (command == "MAINS ON" || command == "MAINS OFF") {
+        mainsCompensation = (command == "MAINS ON");
+        Serial.print(F("Mains compensation "));
+        Serial.println(mainsCompensation ? F("enabled.") : F("disabled."));
+    } else if (command.startsWith("MAINS SET ")) {
+        setMainsVoltage(commandArg(command, 2).toFloat());
+        Serial.println(F("Mains voltage updated."));
+    } else if (command.startsWith("MAINS NOMINAL ")) {
+        float volts = commandArg(command, 2).toFloat();
+        if (volts <= 0) {
+            Serial.println(F("Error: Usage MAINS NOMINAL <V> (> 0)."));
+        } else {
+            setMainsNominal(volts);
+            Serial.println(F("Mains nominal voltage updated."));
+        }
+    } else if (command.startsWith("MAINS CAL ")) {
+        if (calibrateMains(commandArg(command, 2).toFloat())) {
+            Serial.println(F("Mains sense calibrated."));
+        } else {
+            Serial.println(F("Error: No mains sense input configured (MAINS_SENSE_PIN)."));
+        }
+    } else if (command == "JOB") {
+        printJobStats();
+    } else if (command == "JOB START") {
+        startJob();
+        Serial.println(F("Job statistics started."));
+    } else if (command == "JOB END") {
+        if (!endJob()) {
+            Serial.println(F("Error: No job running (JOB START)."));
+        }
+    } else if (command == "AMBIENT") {
+        printAmbientStatus();
+    } else if (command == "AMBIENT ON" || command == "AMBIENT OFF") {
+        ambientCompensation = (command == "AMBIENT ON");
+        Serial.print(F("Ambient compensation "));
+        Serial.println(ambientCompensation ? F("enabled.") : F("disabled."));
+    } else if (command.startsWith("AMBIENT SET ")) {
+        if (setAmbientTemperature(commandArg(command, 2).toFloat())) {
+            Serial.println(F("Ambient temperature updated."));
+        } else {
+            Serial.println(F("Error: Ambient temperature out of range (0-80 °C)."));
+        }
+    } else if (command == "LOSS") {
+        printLosses();
+    } else if (command == "KEEPWARM") {
+        printKeepWarm();
+    } else if (command == "KEEPWARM OFF") {
+        keepWarmStop();
+        Serial.println(F("Keep-warm disabled."));
+    } else if (command.startsWith("KEEPWARM DUE ")) {
+        keepWarmSetDue(commandArg(command, 2).toInt());
+        printKeepWarm();
+    } else if (command.startsWith("KEEPWARM ")) {
+        float standby = commandArg(command, 1).toFloat();
+        if (commandArg(command, 1).length() == 0 || standby < 0 || standby > SAFETY_TEMP_MAX) {
+            Serial.println(F("Error: Usage KEEPWARM <standby temp> [due in s]."));
+        } else {
+            keepWarmStart(standby, commandArg(command, 2).toInt());
+            printKeepWarm();
+        }
+    } else if (command == "ETA" || command.startsWith("ETA ")) {
+        printTimeToSetpoint(commandArg(command, 1).toFloat());
+    } else if (command == "ENERGY") {
+        printEnergy();
+    } else if (command == "ENERGY RESET") {
+        resetEnergy();
+        Serial.println(F("Energy counters reset."));
+    } else if (command.startsWith("ENERGY WATTS ")) {
+        float watts = commandArg(command, 2).toFloat();
+        if (watts <= 0) {
+            Serial.println(F("Error: Usage ENERGY WATTS <W> (> 0)."));
+        } else {
+            heaterWatts = watts;
+            Serial.print(F("Heater power per segment set to "));
+            Serial.print(heaterWatts);
+            Serial.println(F(" W."));
+        }
+    } else if (command == "RAMP") {
+        printTrajectories();
+    } else if (command == "RAMP ON" || command == "RAMP OFF") {
+        setRampEnabled(command == "RAMP ON");
+        printTrajectories();
+    } else if (command.startsWith("RAMP RATE ")) {
+        float rate = commandArg(command, 2).toFloat();
+        if (rate <= 0) {
+            Serial.println(F("Error: Usage RAMP RATE <°C/s>."));
+        } else {
+            rampMaxRate = rate;
+            printTrajectories();
+        }
+    } else if (command.startsWith("RAMP BUDGET ")) {
+        float watts = commandArg(command, 2).toFloat();
+        if (watts <= 0) {
+            Serial.println(F("Error: Usage RAMP BUDGET <W>."));
+        } else {
+            bedPowerBudget = watts;
+            printTrajectories();
+        }
+    } else if (command.startsWith("RAMP QUEUE ")) {
+        int section = commandArg(command, 2).toInt();
+        String value = commandArg(command, 3);
+        float temp = value.toFloat();
+        if (section < 1 || section > 4 || value.length() == 0) {
+            Serial.println(F("Error: Usage RAMP QUEUE <section 1-4> <temp> [hold s]."));
+        } else if (temp < 0 || temp > SAFETY_TEMP_MAX) {
+            Serial.println(F("Error: Setpoint outside safe range."));
+        } else if (!rampEnabled) {
+            Serial.println(F("Error: RAMP QUEUE needs RAMP ON."));
+        } else if (setpointSource != SOURCE_SERIAL) {
+            Serial.println(F("Error: RAMP QUEUE needs SETPOINT_SOURCE SERIAL."));
+        } else if (!queueRamp(section - 1, temp, commandArg(command, 4).toInt())) {
+            Serial.println(F("Error: Ramp queue full."));
+        } else {
+            Serial.print(F("Sec "));
+            Serial.print(section);
+            Serial.print(F(" queued "));
+            Serial.print(temp);
+            Serial.println(F("°C."));
+        }
+    } else if (command.startsWith("RAMP CLEAR")) {
+        int section = commandArg(command, 2).toInt();
+        for (int s = 0; s < NUM_SECTIONS; s++) {
+            if (section == 0 || section == s + 1) clearRampQueue(s);
+        }
+        Serial.println(F("Ramp queue cleared."));
+    } else if (command == "PERIOD") {
+        printSchedule();
+    } else if (command == "PERIOD RESET") {
+        resetScheduleStats();
+        Serial.println(F("Schedule statistics reset."));
+    } else if (command.startsWith("PERIOD TAU ")) {
+        int segment = commandArg(command, 2).toInt();
+        float tau = commandArg(command, 3).toFloat();
+        if (segment < 1 || segment > NUM_SEGMENTS || !setSegmentPeriodFromTau(segment - 1, tau)) {
+            Serial.println(F("Error: Usage PERIOD TAU <segment 1-16> <tau s>."));
+        } else {
+            Serial.print(F("Segment "));
+            Serial.print(segment);
+            Serial.print(F(" period set to "));
+            Serial.print(segmentPeriod[segment - 1]);
+            Serial.println(F(" ms."));
+        }
+    } else if (command.startsWith("PERIOD ")) {
+        String target = commandArg(command, 1);
+        int segment = target.toInt();
+        long period = commandArg(command, 2).toInt();
+        bool ok = (target == "ALL") || (segment >= 1 && segment <= NUM_SEGMENTS);
+        for (int i = 0; ok && i < NUM_SEGMENTS; i++) {
+            if (target == "ALL" || i == segment - 1) ok = setSegmentPeriod(i, period);
+        }
+        if (!ok) {
+            Serial.print(F("Error: Usage PERIOD <segment 1-16|ALL> <ms>, "));
+            Serial.print(SCHEDULE_MINOR_MS);
+            Serial.print(F("-"));
+            Serial.print(SCHEDULE_MAX_PERIOD);
+            Serial.println(F(" ms."));
+        } else {
+            printSchedule();
+        }
+    } else if (command == "ENVELOPE") {
+        printEnvelopeStatus();
+    } else if (command == "ENVELOPE OFF") {
+        stopEnvelope();
+        printEnvelopeStatus();
+    } else if (command.startsWith("ENVELOPE MASK ")) {
+        envelopeMask = strtoul(commandArg(command, 2).c_str(), NULL, 16);
+        printEnvelopeStatus();
+    } else if (command.startsWith("ENVELOPE ")) {
+        unsigned long window = commandArg(command, 1).toInt();
+        String sample = commandArg(command, 2);
+        if (!startEnvelope(window, sample.length() > 0 ? sample.toInt() : ENVELOPE_DEFAULT_SAMPLE)) {
+            Serial.println(F("Error: Usage ENVELOPE <window ms> [sample ms >= 10, <= window, window / sample <= 65000]."));
+        } else {
+            printEnvelopeStatus();
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void printHelp() {
+    Serial.println(F("Available commands:"));
+    Serial.println(F("  ON ALL              - Activate all segments"));
+    Serial.println(F("  OFF ALL             - Deactivate all segments"));
+    Serial.println(F("  ON <n>              - Activate segment <n> (1-16)"));
+    Serial.println(F("  OFF <n>             - Deactivate segment <n> (1-16)"));
+    Serial.println(F("  SET_PWM_RANGE <minPWM> <maxPWM> <minTemp> <maxTemp> - Configure PWM range"));
+    Serial.println(F("  DEBUG ON            - Enable debug mode"));
+    Serial.println(F("  DEBUG OFF           - Disable debug mode"));
+    Serial.println(F("  STATUS              - Display system status"));
+    Serial.println(F("  HELP                - Display this list of commands"));
+    Serial.println(F("  RESET_SAFETY        - Reset thermal safety state"));
+    Serial.println(F("  SET_TEMP <s> <t>    - Set section <s> (1-4) setpoint to <t> °C"));
+    Serial.println(F("  SNAPSHOT            - Print one machine-readable status line"));
+    Serial.println(F("  STREAM <ms>|OFF     - Print SNAPSHOT lines periodically"));
+    Serial.println(F("  SHADOW ON <kp> <ki> <kd> - Run a shadow PID alongside the live one"));
+    Serial.println(F("  SHADOW OFF|STATS|RESET   - Stop shadow / print / clear divergence stats"));
+    Serial.println(F("  SIM <t> [s] [kp ki kd]   - Simulate a heat-up to <t> on the bed model (no relays)"));
+    Serial.println(F("  SIM CHECK|STOP      - Check the model stepping against its exact solution / stop"));
+    Serial.println(F("  SIM COUPLING <1/s>  - Conduction between adjacent segments in the simulation"));
+    Serial.println(F("  STRATEGY [STATS]    - Show per-section strategy / cycle cost per strategy"));
+    Serial.println(F("  STRATEGY <s> <HYST|PID|PIDFF|MODEL|MANUAL> [duty%] - Select section strategy"));
+    Serial.println(F("  CAL START|IN <t>|OUT <pwm>|READ <t>|FIT|SAVE|ABORT - PWM calibration with the Duet"));
+    Serial.println(F("  CAL SET IN <s> <slope> <offset> | OUT <slope> <offset> - Enter a fitted map"));
+    Serial.println(F("  FIELD [n]           - Peak/min/gradient of the interpolated bed field (n x n grid)"));
+    Serial.println(F("  FIELD GRID [n]      - Print the interpolated field, one row per line"));
+    Serial.println(F("  FIELD STATS [RESET] - Mean/max bed spread, mean power and relay switches per hour"));
+    Serial.println(F("  SURFACE <n> <offset> [slope] - Surface offset curve of segment <n>"));
+    Serial.println(F("  SURFACE [ON|OFF|CLEAR|SAVE]  - Show / control on surface temp / clear / store"));
+    Serial.println(F("  FAULT <OPEN|SHORT|OVERTEMP|RUNAWAY> <n> [value] - Inject a fault, report detection latency"));
+    Serial.println(F("  FAULT LINK|CLEAR    - Inject a lost Duet link / clear injected faults"));
+    Serial.println(F("  LINK_TIMEOUT <ms>   - Switch off if the Duet is silent for <ms> (0 = off)"));
+    Serial.println(F("  SETPOINTS [t1,...,t16]        - Show / load 16 independent segment setpoints"));
+    Serial.println(F("  SETPOINT_OFFSETS o1,...,o16   - Per-segment offsets over the section setpoint"));
+    Serial.println(F("  SETPOINT_MODE <SECTION|SEGMENT|OFFSET> - How segment setpoints are built"));
+    Serial.println(F("  SETPOINT_SOURCE <SERIAL|PWM>  - Section setpoints from SET_TEMP or Duet PWM"));
+    Serial.println(F("  MAINS [ON|OFF]      - Show / enable mains voltage compensation"));
+    Serial.println(F("  MAINS SET|NOMINAL|CAL <V> - Pushed voltage / nominal / calibrate sense input"));
+    Serial.println(F("  JOB START|END       - Start per-job statistics / end and print the JOB line"));
+    Serial.println(F("  JOB                 - Print the current (or last) job statistics"));
+    Serial.println(F("  AMBIENT [ON|OFF]    - Show / enable ambient (chamber) compensation"));
+    Serial.println(F("  AMBIENT SET <t>     - Chamber temperature pushed by the Duet (°C)"));
+    Serial.println(F("  LOSS                - Estimated heat loss per segment (W) at the current ambient"));
+    Serial.println(F("  KEEPWARM <t> [due s] - Hold standby temp <t>, reheat in time for the job"));
+    Serial.println(F("  KEEPWARM [DUE <s>|OFF] - Show / set job due time / resume job setpoints"));
+    Serial.println(F("  ETA [t]             - Seconds to reach <t> (default: section setpoints) per section"));
+    Serial.println(F("  ENERGY [RESET]      - Energy used per mode (Wh) / reset counters"));
+    Serial.println(F("  ENERGY WATTS <W>    - Nominal heater power of one segment"));
+    Serial.println(F("  RAMP [ON|OFF]       - Show / enable power-limited setpoint ramps"));
+    Serial.println(F("  RAMP RATE <C/s> | BUDGET <W> - Ramp slew limit / bed power budget"));
+    Serial.println(F("  RAMP QUEUE <s> <t> [hold s] - Queue a setpoint step for section s"));
+    Serial.println(F("  RAMP CLEAR [s]      - Drop queued steps (all sections or one)"));
+    Serial.println(F("  PERIOD [RESET]      - Rate groups with CPU use / reset statistics"));
+    Serial.println(F("  PERIOD <n|ALL> <ms> - Control period of segment n (multiple of 500 ms)"));
+    Serial.println(F("  PERIOD TAU <n> <s>  - Derive segment n's period from its time constant"));
+    Serial.println(F("  ENVELOPE <win> [smp] - Min/max/mean/last/count frames per window (ms)"));
+    Serial.println(F("  ENVELOPE MASK <hex> | OFF - Segments included / stop envelopes"));
+    Serial.println(F("  BAUD [<rate>|ACK]   - Show / switch this port's rate (up to 1000000), confirm it"));
+    Serial.println(F("  BAUD BENCH [bytes]  - Measure transmit throughput on this port"));
+    Serial.println(F("  CONFIG EXPORT [SCRIPT] - Print all settings as one hex blob / as commands"));
+    Serial.println(F("  CONFIG IMPORT <hex>  - Validate and apply a CONFIG blob in one step"));
+    Serial.println(F("  MACRO DEFINE <name> <cmd>;<cmd>;... - Compile and store a macro ($1-$9 = params)"));
+    Serial.println(F("  MACRO [LIST|SHOW <name>|DELETE <name>|CLEAR|STOP] - Manage stored macros"));
+    Serial.println(F("  RUN <name> [p1 ... p9] - Execute a stored macro on the device"));
+    Serial.println(F("  POWER               - Requested / capped / applied heater power (W)"));
+    Serial.println(F("  POWER CAP <W>       - Limit this bed's total heater power (0 = no cap)"));
+    Serial.println(F("  STATE DUMP          - Print the full runtime state as one hex blob"));
+    Serial.println(F("  STATE LOAD <hex>    - Restore a state blob printed by STATE DUMP"));
+    Serial.println(F("  SET_PID <kp> <ki> <kd> - PID gains (PID, PIDFF)"));
+    Serial.println(F("  SET_FF <gain>       - Feedforward duty per °C above ambient (PIDFF)"));
+    Serial.println(F("  SET_MODEL <rate> <tau> <horizon> - Plant model parameters (MODEL)"));
 }
 
 void configurePWMRange(int minPWM, int maxPWM, float minTemp, float maxTemp) {
-    // Implementation of configurePWMRange function
+    if (minPWM >= maxPWM || minTemp >= maxTemp) {
+        Serial.println(F("Error: PWM range minimum must be below maximum."));
+        return;
+    }
+    pwmMinValue = minPWM;
+    pwmMaxValue = maxPWM;
+    tempMin = minTemp;
+    tempMax = maxTemp;
+    pwmCalibrated = false; // A manual range replaces any calibration in use
+    Serial.print(F("PWM range set: "));
+    printCalibration();
 }
 
+// Activation is refused while the thermal safety latch is set, whatever
+// the caller checked before
 void activateAllSegments() {
-    // Implementation of activateAllSegments function
+    if (thermalSafetyTriggered) return;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        activeSegments[i] = true;
+    }
 }
 
+// A deactivated segment forgets its duty, so a later ON starts from zero
+// instead of driving the relay at a stale duty until the next control tick
 void deactivateAllSegments() {
     for (int i = 0; i < NUM_SEGMENTS; i++) {
-        digitalWrite(relayPins[i], LOW);
-        activeSegments[i] = false;
+        deactivateSegment(i + 1);
     }
 }
 
+// Segment numbers are 1-based, as typed in the commands.
+// The control loop drives the relay of an active segment.
 void activateSegment(int segmentNumber) {
-    // Implementation of activateSegment function
+    if (thermalSafetyTriggered) return;
+    activeSegments[segmentNumber - 1] = true;
 }
 
 void deactivateSegment(int segmentNumber) {
-    // Implementation of deactivateSegment function
+    digitalWrite(relayPins[segmentNumber - 1], HIGH); // Relays are active LOW
+    activeSegments[segmentNumber - 1] = false;
+    requestedDuty[segmentNumber - 1] = 0;
+    segmentDuty[segmentNumber - 1] = 0;
 }
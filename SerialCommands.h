@@ -3,9 +3,16 @@
 
 #include <Arduino.h>
 
+// Longest command line; longer lines are dropped. The hex of STATE LOAD and
+// CONFIG IMPORT is not part of the line: it is decoded from the port.
+#define COMMAND_MAX_LEN 200
+
 // Funções relacionadas ao processamento de comandos serial
+bool readCommandLine(Stream &port, String &line);
 void processSerialCommands();
 void processExternalCommand(String command);
+bool processExtendedCommand(const String &command);
+String commandArg(const String &command, int n);
 void printHelp();
 void printSystemStatus();
 void deactivateAllSegments(); // Function declaration
@@ -0,0 +1,110 @@
+#include "Setpoints.h"
+#include "MY-HeatBed_Controller.h" // Para acessar targetTemp e NUM_SEGMENTS
+#include "Safety.h"
+#include "TemperatureControl.h" // Para acessar readTargetTemperature
+#include "KeepWarm.h"
+#include "Trajectory.h"
+
+float segmentSetpoint[16] = {0};
+uint8_t setpointMode = SETPOINT_SECTION;
+uint8_t setpointSource = SOURCE_SERIAL;
+float segmentSetpointValue[16] = {0};
+float segmentSetpointOffset[16] = {0};
+
+// Staged by command, swapped in at the next tick so all 16 change together
+static float pendingValues[16];
+static bool pendingIsOffset = false;
+static bool pendingValid = false;
+
+// Parses "v1,v2,...,v16" into the staging buffer. Nothing is staged unless
+// all 16 values are present and in range.
+bool stageSetpoints(const String &list, bool offsets) {
+    float values[16];
+    int start = 0;
+    for (int i = 0; i < 16; i++) {
+        int end = list.indexOf(',', start);
+        if (end < 0) {
+            if (i != 15) return false;
+            end = list.length();
+        }
+        String field = list.substring(start, end);
+        if (field.length() == 0) return false;
+        values[i] = field.toFloat();
+
+        float limit = offsets ? SAFETY_TEMP_MAX : 0;
+        if (values[i] < -limit || values[i] > SAFETY_TEMP_MAX) return false;
+        start = end + 1;
+    }
+    if (start <= (int)list.length()) return false; // More than 16 values
+
+    for (int i = 0; i < 16; i++) {
+        pendingValues[i] = values[i];
+    }
+    pendingIsOffset = offsets;
+    pendingValid = true;
+    return true;
+}
+
+// Called at the start of every control tick
+void updateSetpoints() {
+    if (pendingValid) {
+        float *dest = pendingIsOffset ? segmentSetpointOffset : segmentSetpointValue;
+        for (int i = 0; i < 16; i++) {
+            dest[i] = pendingValues[i];
+        }
+        pendingValid = false;
+    }
+
+    if (setpointSource == SOURCE_PWM) {
+        static uint8_t pwmLost = 0; // Sections already reported
+        for (int s = 0; s < NUM_SECTIONS; s++) {
+            float temp = readTargetTemperature(s);
+            if (temp != -999.0) {
+                targetTemp[s] = constrain(temp, 0.0, SAFETY_TEMP_MAX);
+                bitClear(pwmLost, s);
+                continue;
+            }
+            // No usable signal: fail safe rather than hold a stale setpoint
+            targetTemp[s] = 0;
+            if (!bitRead(pwmLost, s)) {
+                Serial.print(F("ALERT: PWM setpoint signal lost on section "));
+                Serial.print(s + 1);
+                Serial.println(F(". Target set to 0."));
+                bitSet(pwmLost, s);
+            }
+        }
+    }
+
+    updateTrajectories(); // targetTemp -> rate-limited sectionRamp
+
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        float base = sectionRamp[i / (NUM_SEGMENTS / NUM_SECTIONS)];
+        float sp;
+        if (setpointMode == SETPOINT_SEGMENT) {
+            sp = segmentSetpointValue[i];
+        } else if (setpointMode == SETPOINT_OFFSET) {
+            sp = base + segmentSetpointOffset[i];
+        } else {
+            sp = base;
+        }
+        segmentSetpoint[i] = constrain(sp, 0.0, SAFETY_TEMP_MAX);
+    }
+
+    applyKeepWarm(); // Lowers setpoints to standby between jobs
+}
+
+const char setpointModeNames[][8] PROGMEM = {"SECTION", "SEGMENT", "OFFSET"};
+
+void printSetpoints() {
+    Serial.print(F("Setpoint mode: "));
+    Serial.print((const __FlashStringHelper *)setpointModeNames[setpointMode]);
+    Serial.print(F(" | Source: "));
+    Serial.println(setpointSource == SOURCE_PWM ? F("PWM") : F("SERIAL"));
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        Serial.print(F("Segment "));
+        Serial.print(i + 1);
+        Serial.print(F(" | Setpoint: "));
+        Serial.print(segmentSetpoint[i]);
+        Serial.println(F("°C"));
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef SETPOINTS_H
+#define SETPOINTS_H
+
+#include <Arduino.h>
+
+// Setpoints por segmento. The control loops only ever read segmentSetpoint[],
+// which is rebuilt once per control tick from the selected mode.
+enum SetpointMode {
+    SETPOINT_SECTION = 0, // Each segment follows its section's targetTemp
+    SETPOINT_SEGMENT,     // 16 independent setpoints
+    SETPOINT_OFFSET       // Section targetTemp plus a per-segment offset
+};
+
+// Where the section setpoints (targetTemp) come from
+enum SetpointSource {
+    SOURCE_SERIAL = 0, // SET_TEMP commands
+    SOURCE_PWM         // Duet PWM inputs, read every control tick
+};
+
+extern float segmentSetpoint[16];
+extern uint8_t setpointMode;
+extern uint8_t setpointSource;
+extern const char setpointModeNames[][8] PROGMEM; // Indexed by setpointMode
+extern float segmentSetpointValue[16]; // Used in SETPOINT_SEGMENT mode
+extern float segmentSetpointOffset[16]; // Used in SETPOINT_OFFSET mode
+
+// Funções de setpoints
+bool stageSetpoints(const String &list, bool offsets);
+void updateSetpoints();
+void printSetpoints();
+
+#endif
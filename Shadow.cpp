@@ -0,0 +1,110 @@
+#include "Shadow.h"
+#include "MY-HeatBed_Controller.h" // Para acessar o estado do PID real
+#include "TemperatureControl.h" // Para acessar computePID
+#include "Power.h" // Para acessar relayOnTime
+
+bool shadowEnabled = false;
+float shadowKp = 0;
+float shadowKi = 0;
+float shadowKd = 0;
+
+// Shadow PID state, independent from the live pidIntegral/pidLastError
+static float shadowIntegral[NUM_SEGMENTS] = {0};
+static float shadowLastError[NUM_SEGMENTS] = {0};
+static unsigned long shadowLastUpdate[NUM_SEGMENTS] = {0};
+
+// Per-segment divergence statistics (shadow output - live output)
+static unsigned long shadowSamples[NUM_SEGMENTS] = {0};
+static float shadowSumDiff[NUM_SEGMENTS] = {0};
+static float shadowSumAbsDiff[NUM_SEGMENTS] = {0};
+static float shadowMaxAbsDiff[NUM_SEGMENTS] = {0};
+static unsigned long shadowRelayMismatch[NUM_SEGMENTS] = {0};
+static float shadowSumRelayMs[NUM_SEGMENTS] = {0}; // |on-time difference| per relay window
+
+void shadowResetStats() {
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        shadowSamples[i] = 0;
+        shadowSumDiff[i] = 0;
+        shadowSumAbsDiff[i] = 0;
+        shadowMaxAbsDiff[i] = 0;
+        shadowRelayMismatch[i] = 0;
+        shadowSumRelayMs[i] = 0;
+    }
+}
+
+void shadowStart(float kp, float ki, float kd) {
+    shadowKp = kp;
+    shadowKi = ki;
+    shadowKd = kd;
+
+    // Start from the live controller state so both begin aligned
+    unsigned long now = millis();
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        shadowIntegral[i] = pidIntegral[i];
+        shadowLastError[i] = pidLastError[i];
+        shadowLastUpdate[i] = pidLastUpdate[i] ? pidLastUpdate[i] : now;
+    }
+    shadowResetStats();
+    shadowEnabled = true;
+}
+
+void shadowStop() {
+    shadowEnabled = false;
+}
+
+void shadowUpdate(int segment, float currentTemp, float target, float liveOutput) {
+    if (!shadowEnabled || currentTemp == -999.0) return;
+
+    float output = computePID(shadowKp, shadowKi, shadowKd, shadowIntegral[segment],
+                              shadowLastError[segment], shadowLastUpdate[segment],
+                              currentTemp, target);
+
+    float diff = output - liveOutput;
+    float absDiff = fabs(diff);
+    shadowSamples[segment]++;
+    shadowSumDiff[segment] += diff;
+    shadowSumAbsDiff[segment] += absDiff;
+    if (absDiff > shadowMaxAbsDiff[segment]) {
+        shadowMaxAbsDiff[segment] = absDiff;
+    }
+
+    // Relays are time-proportioned: compare the on-times each duty would
+    // drive, and count windows where only one of them energises the relay
+    unsigned long shadowOn = relayOnTime(output);
+    unsigned long liveOn = relayOnTime(liveOutput);
+    shadowSumRelayMs[segment] += shadowOn > liveOn ? shadowOn - liveOn : liveOn - shadowOn;
+    if ((shadowOn > 0) != (liveOn > 0)) {
+        shadowRelayMismatch[segment]++;
+    }
+}
+
+// One line per segment with samples:
+// SHADOW seg=<n> n=<samples> bias=<mean diff> mad=<mean |diff|> max=<max |diff|>
+//        relay=<mean |on-time diff| ms> flips=<windows energised by only one>
+void printShadowStats() {
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (shadowSamples[i] == 0) continue;
+        Serial.print(F("SHADOW seg="));
+        Serial.print(i + 1);
+        Serial.print(F(" n="));
+        Serial.print(shadowSamples[i]);
+        Serial.print(F(" bias="));
+        Serial.print(shadowSumDiff[i] / shadowSamples[i], 3);
+        Serial.print(F(" mad="));
+        Serial.print(shadowSumAbsDiff[i] / shadowSamples[i], 3);
+        Serial.print(F(" max="));
+        Serial.print(shadowMaxAbsDiff[i], 3);
+        Serial.print(F(" relay="));
+        Serial.print(shadowSumRelayMs[i] / shadowSamples[i], 0);
+        Serial.print(F(" flips="));
+        Serial.println(shadowRelayMismatch[i]);
+    }
+}
+
+void printShadowStatsPeriodically() {
+    static unsigned long lastPrintTime = 0;
+    if (shadowEnabled && millis() - lastPrintTime >= SHADOW_REPORT_INTERVAL) {
+        lastPrintTime = millis();
+        printShadowStats();
+    }
+}
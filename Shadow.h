@@ -0,0 +1,23 @@
+#ifndef SHADOW_H
+#define SHADOW_H
+
+#include <Arduino.h>
+
+// Controlador sombra: corre em paralelo com o PID real, sem atuar nos relés
+extern bool shadowEnabled;
+extern float shadowKp;
+extern float shadowKi;
+extern float shadowKd;
+
+// Interval between streamed divergence reports (in ms)
+#define SHADOW_REPORT_INTERVAL 5000
+
+// Funções do controlador sombra
+void shadowStart(float kp, float ki, float kd);
+void shadowStop();
+void shadowResetStats();
+void shadowUpdate(int segment, float currentTemp, float target, float liveOutput);
+void printShadowStats();
+void printShadowStatsPeriodically();
+
+#endif
@@ -0,0 +1,243 @@
+#include "StateDump.h"
+#include <stddef.h>
+#include "MY-HeatBed_Controller.h" // Para acessar setpoints, PID e faixa PWM
+#include "Pins.h"
+#include "ControlStrategy.h"
+#include "Calibration.h"
+#include "Field.h"
+#include "Safety.h"
+#include "Storage.h"
+#include "Setpoints.h"
+#include "Power.h"
+#include "Mains.h"
+#include "KeepWarm.h"
+#include "Trajectory.h"
+#include "Schedule.h"
+#include "Ambient.h"
+
+// State flags
+#define STATE_FLAG_SAFETY 0x01
+#define STATE_FLAG_DEBUG 0x02
+#define STATE_FLAG_SURFACE 0x04
+#define STATE_FLAG_CALIBRATED 0x08
+#define STATE_FLAG_MAINS 0x10
+#define STATE_FLAG_AMBIENT 0x20
+
+// Timestamps are stored as ages so the blob replays on any clock
+struct ControllerState {
+    uint8_t version;
+    uint8_t flags;
+    uint16_t activeMask;
+    uint16_t hysteresisMask;
+    uint32_t uptimeMs;
+
+    // Setpoints and control
+    float targetTemp[4];
+    uint8_t setpointMode;
+    uint8_t setpointSource;
+    float segmentSetpointValue[16];
+    float segmentSetpointOffset[16];
+    uint8_t strategy[4];
+    float manualDuty[4];
+    float segmentDuty[16];
+    uint16_t segmentPeriod[16];
+
+    // Controller state
+    float pidIntegral[16];
+    float pidLastError[16];
+    uint16_t pidAgeMs[16];
+
+    // Filter state: temperature cache and its age
+    float cachedTemperatures[16];
+    uint16_t readAgeMs[16];
+
+    // Configuration
+    float pidKp, pidKi, pidKd;
+    float ffGain, modelHeatRate, modelTau, modelHorizon;
+    int16_t pwmMinValue, pwmMaxValue;
+    float tempMin, tempMax;
+    LinearMap pwmInMap[4];
+    LinearMap pwmOutMap;
+    float surfaceOffset[16];
+    float surfaceSlope[16];
+    uint32_t duetLinkTimeout;
+
+    // Mains compensation
+    uint16_t mainsFactorQ12;
+    float mainsNominal;
+    float mainsVolts;
+
+    float powerCapWatts;
+    KeepWarmRecord keepWarm;
+    RampRecord ramps;
+    AmbientRecord ambient;
+
+    uint8_t checksum;
+};
+
+// Checksum covers everything up to the checksum byte, not trailing padding
+#define STATE_CHECKSUM_SIZE (offsetof(ControllerState, checksum) + 1)
+
+static uint16_t ageMs(unsigned long now, unsigned long then) {
+    unsigned long age = now - then;
+    return age > 65535UL ? 65535 : age;
+}
+
+void dumpState() {
+    ControllerState st;
+    unsigned long now = millis();
+
+    st.version = STATE_VERSION;
+    st.flags = (thermalSafetyTriggered ? STATE_FLAG_SAFETY : 0) |
+               (debugMode ? STATE_FLAG_DEBUG : 0) |
+               (surfaceControl ? STATE_FLAG_SURFACE : 0) |
+               (pwmCalibrated ? STATE_FLAG_CALIBRATED : 0) |
+               (mainsCompensation ? STATE_FLAG_MAINS : 0) |
+               (ambientCompensation ? STATE_FLAG_AMBIENT : 0);
+    st.activeMask = 0;
+    st.hysteresisMask = 0;
+    st.uptimeMs = now;
+
+    for (int i = 0; i < 16; i++) {
+        if (activeSegments[i]) st.activeMask |= (1U << i);
+        if (hysteresisOn[i]) st.hysteresisMask |= (1U << i);
+        st.segmentDuty[i] = segmentDuty[i];
+        st.segmentPeriod[i] = segmentPeriod[i];
+        st.segmentSetpointValue[i] = segmentSetpointValue[i];
+        st.segmentSetpointOffset[i] = segmentSetpointOffset[i];
+        st.pidIntegral[i] = pidIntegral[i];
+        st.pidLastError[i] = pidLastError[i];
+        st.pidAgeMs[i] = ageMs(now, pidLastUpdate[i]);
+        st.cachedTemperatures[i] = cachedTemperatures[i];
+        st.readAgeMs[i] = ageMs(now, lastReadTime[i]);
+        st.surfaceOffset[i] = surfaceOffset[i];
+        st.surfaceSlope[i] = surfaceSlope[i];
+    }
+    for (int s = 0; s < 4; s++) {
+        st.targetTemp[s] = targetTemp[s];
+        st.strategy[s] = sectionStrategy[s];
+        st.manualDuty[s] = manualDuty[s];
+        st.pwmInMap[s] = pwmInMap[s];
+    }
+
+    st.setpointMode = setpointMode;
+    st.setpointSource = setpointSource;
+    st.pidKp = pidKp;
+    st.pidKi = pidKi;
+    st.pidKd = pidKd;
+    st.ffGain = ffGain;
+    st.modelHeatRate = modelHeatRate;
+    st.modelTau = modelTau;
+    st.modelHorizon = modelHorizon;
+    st.pwmMinValue = pwmMinValue;
+    st.pwmMaxValue = pwmMaxValue;
+    st.tempMin = tempMin;
+    st.tempMax = tempMax;
+    st.pwmOutMap = pwmOutMap;
+    st.duetLinkTimeout = duetLinkTimeout;
+    st.mainsFactorQ12 = mainsFactorQ12;
+    st.mainsNominal = mainsNominalVoltage();
+    st.mainsVolts = mainsVoltage();
+    st.powerCapWatts = powerCapWatts;
+    saveKeepWarm(st.keepWarm);
+    saveRamps(st.ramps);
+    saveAmbient(st.ambient);
+    st.checksum = storageChecksum(&st, STATE_CHECKSUM_SIZE);
+
+    Serial.print(F("STATE "));
+    printHexRecord(&st, sizeof(st));
+    Serial.println();
+}
+
+// Applies the whole blob or nothing. Never while latched, and a blob can
+// only set the latch, not clear it: RESET_SAFETY is the only way out.
+bool loadState(Stream &port) {
+    ControllerState st;
+
+    // Read the whole line even when refusing, so the hex is not taken for commands
+    bool read = readHexRecord(port, &st, sizeof(st));
+    if (thermalSafetyTriggered) {
+        Serial.println(F("Error: System in thermal safety state. Reset before STATE LOAD."));
+        return false;
+    }
+    if (!read) {
+        Serial.println(F("Error: State blob has the wrong size or is not hexadecimal."));
+        return false;
+    }
+    if (st.version != STATE_VERSION || st.checksum != storageChecksum(&st, STATE_CHECKSUM_SIZE)) {
+        Serial.println(F("Error: State blob version or checksum mismatch."));
+        return false;
+    }
+
+    unsigned long now = millis();
+    if (st.flags & STATE_FLAG_SAFETY) thermalSafetyTriggered = true;
+    debugMode = st.flags & STATE_FLAG_DEBUG;
+    surfaceControl = st.flags & STATE_FLAG_SURFACE;
+    pwmCalibrated = st.flags & STATE_FLAG_CALIBRATED;
+    mainsCompensation = st.flags & STATE_FLAG_MAINS;
+    ambientCompensation = st.flags & STATE_FLAG_AMBIENT;
+
+    for (int i = 0; i < 16; i++) {
+        // Through the same latch-checked path as ON
+        if (st.activeMask & (1U << i)) {
+            activateSegment(i + 1);
+        } else {
+            deactivateSegment(i + 1);
+        }
+        hysteresisOn[i] = st.hysteresisMask & (1U << i);
+        if (activeSegments[i]) { // An inactive segment keeps the zero duty deactivateSegment() left
+            segmentDuty[i] = st.segmentDuty[i];
+            requestedDuty[i] = st.segmentDuty[i];
+        }
+        segmentSetpointValue[i] = st.segmentSetpointValue[i];
+        segmentSetpointOffset[i] = st.segmentSetpointOffset[i];
+        setSegmentPeriod(i, st.segmentPeriod[i]); // Rounded and range-checked; out of range keeps the current one
+        pidIntegral[i] = st.pidIntegral[i];
+        pidLastError[i] = st.pidLastError[i];
+        pidLastUpdate[i] = now - st.pidAgeMs[i];
+        cachedTemperatures[i] = st.cachedTemperatures[i];
+        lastReadTime[i] = now - st.readAgeMs[i];
+        surfaceOffset[i] = st.surfaceOffset[i];
+        surfaceSlope[i] = st.surfaceSlope[i];
+    }
+    for (int s = 0; s < 4; s++) {
+        targetTemp[s] = st.targetTemp[s];
+        sectionStrategy[s] = st.strategy[s] < STRATEGY_COUNT ? st.strategy[s] : (uint8_t)STRATEGY_PID;
+        manualDuty[s] = st.manualDuty[s];
+        pwmInMap[s] = st.pwmInMap[s];
+    }
+
+    setpointMode = st.setpointMode <= SETPOINT_OFFSET ? st.setpointMode : (uint8_t)SETPOINT_SECTION;
+    setpointSource = st.setpointSource <= SOURCE_PWM ? st.setpointSource : (uint8_t)SOURCE_SERIAL;
+    pidKp = st.pidKp;
+    pidKi = st.pidKi;
+    pidKd = st.pidKd;
+    ffGain = st.ffGain;
+    modelHeatRate = st.modelHeatRate;
+    modelTau = st.modelTau;
+    modelHorizon = st.modelHorizon;
+    pwmMinValue = st.pwmMinValue;
+    pwmMaxValue = st.pwmMaxValue;
+    tempMin = st.tempMin;
+    tempMax = st.tempMax;
+    pwmOutMap = st.pwmOutMap;
+    duetLinkTimeout = st.duetLinkTimeout;
+    noteDuetActivity();
+    if (st.mainsNominal > 0) setMainsNominal(st.mainsNominal);
+    setMainsVoltage(st.mainsVolts); // Used when there is no sense input, as after MAINS SET
+    mainsFactorQ12 = mainsCompensation ? constrain(st.mainsFactorQ12, (uint16_t)MAINS_FACTOR_MIN, (uint16_t)MAINS_FACTOR_MAX)
+                                       : (uint16_t)MAINS_FACTOR_ONE;
+    powerCapWatts = st.powerCapWatts >= 0 ? st.powerCapWatts : 0;
+    restoreKeepWarm(st.keepWarm);
+    restoreRamps(st.ramps); // After setpointSource: a queue needs RAMP ON and a serial source
+    restoreAmbient(st.ambient);
+
+    // Last, once the gains and PWM range it may use are in place
+    updateSetpoints(); // Rebuild segmentSetpoint[] from the loaded state
+
+    // A latched dump replays latched: relays stay off
+    if (thermalSafetyTriggered) {
+        deactivateAllSegments();
+    }
+    return true;
+}
@@ -0,0 +1,13 @@
+#ifndef STATE_DUMP_H
+#define STATE_DUMP_H
+
+#include <Arduino.h>
+
+// Exportação/importação do estado completo do controlador, para reproduzir
+// problemas de campo. One line: STATE <hex blob>
+#define STATE_VERSION 8
+
+void dumpState();
+bool loadState(Stream &port);
+
+#endif
@@ -0,0 +1,51 @@
+#include "Storage.h"
+
+// Sum of all bytes of the record except the trailing checksum byte
+uint8_t storageChecksum(const void *record, unsigned int size) {
+    const uint8_t *bytes = (const uint8_t *)record;
+    uint8_t sum = 0;
+    for (unsigned int i = 0; i < size - 1; i++) {
+        sum += bytes[i];
+    }
+    return sum;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Streamed byte by byte: no second copy of the record in RAM
+void printHexRecord(const void *record, unsigned int size) {
+    const uint8_t *bytes = (const uint8_t *)record;
+    for (unsigned int i = 0; i < size; i++) {
+        if (bytes[i] < 0x10) Serial.print('0');
+        Serial.print(bytes[i], HEX);
+    }
+}
+
+// Decoded straight from the port, up to the end of the line, so the hex
+// text is never buffered. False unless the line is exactly size bytes of hex.
+bool readHexRecord(Stream &port, void *record, unsigned int size) {
+    uint8_t *bytes = (uint8_t *)record;
+    unsigned int digits = 0;
+    bool valid = true;
+    uint8_t c;
+    while (port.readBytes(&c, 1) == 1 && c != '\n') {
+        if (c == ' ' || c == '\r') continue;
+        int value = hexValue(c);
+        if (value < 0 || digits >= size * 2) {
+            valid = false; // Keep reading: the rest of the line is dropped
+            continue;
+        }
+        if (digits % 2 == 0) {
+            bytes[digits / 2] = value << 4;
+        } else {
+            bytes[digits / 2] |= value;
+        }
+        digits++;
+    }
+    return valid && digits == size * 2;
+}
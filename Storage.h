@@ -0,0 +1,19 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <Arduino.h>
+
+// Mapa da EEPROM (Arduino Mega: 4 KB)
+#define CAL_EEPROM_ADDR 0      // PWM calibration (Calibration.cpp)
+#define SURFACE_EEPROM_ADDR 64 // Surface offset curves (Field.cpp)
+#define MACRO_EEPROM_ADDR 256  // Command macros (Macro.cpp)
+#define MACRO_EEPROM_SIZE 1024
+
+// Records start with a magic number and end with this checksum byte
+uint8_t storageChecksum(const void *record, unsigned int size);
+
+// Records sent over serial as one hex string (STATE, CONFIG)
+void printHexRecord(const void *record, unsigned int size);
+bool readHexRecord(Stream &port, void *record, unsigned int size);
+
+#endif
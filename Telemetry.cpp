@@ -0,0 +1,62 @@
+#include "Telemetry.h"
+#include "Pins.h" // Para acessar activeSegments e targetTemp
+#include "TemperatureControl.h" // Para acessar cachedTemperatures
+#include "Safety.h"
+#include "ControlStrategy.h" // Para acessar segmentDuty
+#include "Mains.h"
+
+unsigned long streamInterval = 0;
+
+void printSnapshot() {
+    unsigned int mask = 0;
+    unsigned int relays = 0;
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (activeSegments[i]) mask |= (1U << i);
+        if (digitalRead(relayPins[i]) == LOW) relays |= (1U << i); // Relays are active LOW
+    }
+
+    Serial.print(F("SNAP ms="));
+    Serial.print(millis());
+    Serial.print(F(" safety="));
+    Serial.print(thermalSafetyTriggered ? 1 : 0);
+    Serial.print(F(" mask=0x"));
+    Serial.print(mask, HEX);
+    Serial.print(F(" relay=0x"));
+    Serial.print(relays, HEX);
+    Serial.print(F(" sp="));
+    for (int i = 0; i < 4; i++) {
+        if (i > 0) Serial.print(',');
+        Serial.print(targetTemp[i]);
+    }
+    // Cached values only: a snapshot must not trigger new ADC reads
+    Serial.print(F(" t="));
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (i > 0) Serial.print(',');
+        Serial.print(cachedTemperatures[i]);
+    }
+    // Duties as last applied by the control loop, for host-side models
+    Serial.print(F(" duty="));
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (i > 0) Serial.print(',');
+        Serial.print(segmentDuty[i], 3);
+    }
+    Serial.print(F(" mains="));
+    Serial.println((float)mainsFactorQ12 / MAINS_FACTOR_ONE, 3);
+}
+
+void streamTelemetry() {
+    static unsigned long lastStreamTime = 0;
+    if (streamInterval > 0 && millis() - lastStreamTime >= streamInterval) {
+        lastStreamTime = millis();
+        printSnapshot();
+    }
+}
+
+void emitEvent(const __FlashStringHelper *type, int index, float value) {
+    Serial.print(F("EVT "));
+    Serial.print(type);
+    Serial.print(' ');
+    Serial.print(index);
+    Serial.print(' ');
+    Serial.println(value);
+}
@@ -0,0 +1,21 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+// Linhas de estado legíveis por máquina, para ferramentas no host
+// SNAP ms=<millis> safety=<0|1> mask=<hex> relay=<hex> sp=<s1>,...,<s4>
+//      t=<t1>,...,<t16> duty=<d1>,...,<d16> mains=<duty factor>
+void printSnapshot();
+
+// Shortest accepted streaming period (in ms)
+#define STREAM_MIN_INTERVAL 10
+
+// Streaming period in ms, 0 = off
+extern unsigned long streamInterval;
+void streamTelemetry();
+
+// EVT <type> <index> <value> - emitted asynchronously when something changes
+void emitEvent(const __FlashStringHelper *type, int index, float value);
+
+#endif
@@ -9,8 +9,14 @@ extern float cachedTemperatures[16];
 // Funções relacionadas ao controle de temperatura
 void setupPins();
 float readTemperature(int sensorPin);
+float sampleTemperature(int sensorIndex);
+float thermistorTemperature(int analogValue);
+float readTargetTemperature(int secIndex);
 float calculatePID(int segmentIndex, float currentTemp, float targetTemp);
-void controlHeatingWithPID(int secIndex, int start, int end);
+float computePIDRaw(float kp, float ki, float kd, float &integralState, float &lastError,
+                    unsigned long &lastUpdate, float currentTemp, float targetTemp);
+float computePID(float kp, float ki, float kd, float &integralState, float &lastError,
+                 unsigned long &lastUpdate, float currentTemp, float targetTemp);
 void updateTemperaturePWM(int secIndex, int start, int end);
 void configurePWMRange(int minPWM, int maxPWM, float minTemp, float maxTemp);
 
@@ -0,0 +1,239 @@
+#include "Trajectory.h"
+#include "MY-HeatBed_Controller.h" // Para acessar targetTemp, NUM_SEGMENTS e NUM_SECTIONS
+#include "ControlStrategy.h" // Para o modelo térmico
+#include "Energy.h" // Para acessar heaterWatts
+#include "TemperatureControl.h"
+#include "Telemetry.h"
+#include "Ambient.h"
+#include "Setpoints.h"
+
+#define SEGMENTS_PER_SECTION (NUM_SEGMENTS / NUM_SECTIONS)
+
+bool rampEnabled = false;
+float rampMaxRate = 0.5;
+float bedPowerBudget = 1000.0;
+float sectionRamp[4] = {0, 0, 0, 0};
+static float lastRate[4] = {0, 0, 0, 0};
+
+struct RampStep {
+    float temp;
+    unsigned long holdMs; // Time at temp before the next step starts
+};
+
+static RampStep rampQueue[4][RAMP_QUEUE_SIZE];
+static uint8_t queueHead[4] = {0, 0, 0, 0};
+static uint8_t queueCount[4] = {0, 0, 0, 0};
+static bool holding[4] = {false, false, false, false};
+static unsigned long holdUntil[4] = {0, 0, 0, 0};
+static unsigned long currentHoldMs[4] = {0, 0, 0, 0};
+
+// Queued steps only advance while ramps run, and a PWM source rewrites
+// targetTemp every tick, so the queue is only usable with both in place
+bool rampQueueReady() {
+    return rampEnabled && setpointSource == SOURCE_SERIAL;
+}
+
+bool queueRamp(int section, float temp, unsigned long holdSeconds) {
+    if (!rampQueueReady() || queueCount[section] >= RAMP_QUEUE_SIZE) return false;
+    uint8_t slot = (queueHead[section] + queueCount[section]) % RAMP_QUEUE_SIZE;
+    rampQueue[section][slot].temp = temp;
+    rampQueue[section][slot].holdMs = holdSeconds * 1000UL;
+    queueCount[section]++;
+    return true;
+}
+
+void clearRampQueue(int section) {
+    queueCount[section] = 0;
+    holding[section] = false;
+    currentHoldMs[section] = 0;
+}
+
+// Average temperature of the active segments of a section, -999 if none
+static float sectionTemperature(int section) {
+    float sum = 0;
+    int count = 0;
+    for (int i = section * SEGMENTS_PER_SECTION; i < (section + 1) * SEGMENTS_PER_SECTION; i++) {
+        if (!activeSegments[i]) continue;
+        float temp = readTemperature(tempSensors[i]);
+        if (temp != -999.0) {
+            sum += temp;
+            count++;
+        }
+    }
+    return count > 0 ? sum / count : -999.0;
+}
+
+static int activeInSection(int section) {
+    int count = 0;
+    for (int i = section * SEGMENTS_PER_SECTION; i < (section + 1) * SEGMENTS_PER_SECTION; i++) {
+        if (activeSegments[i]) count++;
+    }
+    return count;
+}
+
+void setRampEnabled(bool enabled) {
+    if (enabled && !rampEnabled) {
+        // Start every ramp from where the bed is now
+        for (int s = 0; s < NUM_SECTIONS; s++) {
+            float temp = sectionTemperature(s);
+            sectionRamp[s] = (temp == -999.0) ? targetTemp[s] : min(temp, targetTemp[s]);
+        }
+    }
+    rampEnabled = enabled;
+}
+
+// Once a section has settled on its target, hold for the step's time and
+// then promote the next queued step to targetTemp
+static void advanceQueue(int section, unsigned long now) {
+    if (queueCount[section] == 0 || sectionRamp[section] != targetTemp[section]) return;
+
+    if (!holding[section]) {
+        float temp = sectionTemperature(section);
+        if (temp != -999.0 && fabs(temp - targetTemp[section]) > RAMP_SETTLE_BAND) return;
+        holding[section] = true;
+        holdUntil[section] = now + currentHoldMs[section];
+        return;
+    }
+    if ((long)(now - holdUntil[section]) < 0) return;
+
+    RampStep &step = rampQueue[section][queueHead[section]];
+    queueHead[section] = (queueHead[section] + 1) % RAMP_QUEUE_SIZE;
+    queueCount[section]--;
+    targetTemp[section] = step.temp;
+    currentHoldMs[section] = step.holdMs;
+    holding[section] = false;
+    emitEvent(F("SETPOINT"), section + 1, step.temp);
+}
+
+// Called from updateSetpoints() every control tick. Steady-state duty from
+// the first-order model is duty = (T - ambient) / (heatRate * tau); whatever
+// the holding sections leave of the power budget is shared between the
+// segments still ramping up, and heatRate * spare duty is their rate.
+void updateTrajectories() {
+    static unsigned long lastTime = 0;
+    unsigned long now = millis();
+    float dt = (now - lastTime) / 1000.0;
+    lastTime = now;
+
+    if (!rampQueueReady()) {
+        // RAMP OFF or a PWM source takes over: pending steps are dropped
+        for (int s = 0; s < NUM_SECTIONS; s++) {
+            if (queueCount[s] > 0) clearRampQueue(s);
+        }
+    }
+
+    if (!rampEnabled) {
+        for (int s = 0; s < NUM_SECTIONS; s++) {
+            sectionRamp[s] = targetTemp[s];
+            lastRate[s] = 0;
+        }
+        return;
+    }
+
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        advanceQueue(s, now);
+    }
+
+    float holdingPower = 0;
+    int rampingSegments = 0;
+    float fullRise = modelHeatRate * modelTau;
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        int active = activeInSection(s);
+        if (active == 0) continue;
+        float holdDuty = fullRise > 0 ? (sectionRamp[s] - ambientTemperature()) / fullRise : 0;
+        holdingPower += constrain(holdDuty, 0.0, 1.0) * heaterWatts * active;
+        if (targetTemp[s] > sectionRamp[s]) rampingSegments += active;
+    }
+
+    float spareDuty = 0;
+    if (rampingSegments > 0 && heaterWatts > 0) {
+        spareDuty = max(bedPowerBudget - holdingPower, 0.0f) / (rampingSegments * heaterWatts);
+    }
+
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        float error = targetTemp[s] - sectionRamp[s];
+        if (error <= 0) {
+            // Cooling is passive; no reason to hold the setpoint up
+            sectionRamp[s] = targetTemp[s];
+            lastRate[s] = 0;
+            continue;
+        }
+
+        float holdDuty = fullRise > 0 ? (sectionRamp[s] - ambientTemperature()) / fullRise : 0;
+        float duty = min(spareDuty, 1.0f - constrain(holdDuty, 0.0, 1.0));
+        float rate = min(modelHeatRate * duty, rampMaxRate);
+        rate = min(rate, error / RAMP_BLEND_S); // Blend into the target
+
+        float next = sectionRamp[s] + rate * dt;
+        float temp = sectionTemperature(s);
+        if (temp != -999.0 && next > temp + RAMP_MAX_LEAD) {
+            next = max(sectionRamp[s], temp + RAMP_MAX_LEAD);
+        }
+        if (targetTemp[s] - next < RAMP_SNAP) next = targetTemp[s];
+
+        lastRate[s] = dt > 0 ? (next - sectionRamp[s]) / dt : 0;
+        sectionRamp[s] = next;
+    }
+}
+
+void printTrajectories() {
+    Serial.print(F("Ramp: "));
+    Serial.print(rampEnabled ? F("ON") : F("OFF"));
+    Serial.print(F(" | Max rate: "));
+    Serial.print(rampMaxRate, 3);
+    Serial.print(F(" °C/s | Budget: "));
+    Serial.print(bedPowerBudget, 0);
+    Serial.println(F(" W"));
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        Serial.print(F("Sec "));
+        Serial.print(s + 1);
+        Serial.print(F(" | Target: "));
+        Serial.print(targetTemp[s]);
+        Serial.print(F("°C | Ramp: "));
+        Serial.print(sectionRamp[s]);
+        Serial.print(F("°C | Rate: "));
+        Serial.print(lastRate[s], 3);
+        Serial.print(F(" °C/s | Queued: "));
+        Serial.println(queueCount[s]);
+    }
+}
+
+void saveRamps(RampRecord &rec) {
+    unsigned long now = millis();
+    rec.enabled = rampEnabled;
+    rec.maxRate = rampMaxRate;
+    rec.powerBudget = bedPowerBudget;
+    rec.holdingMask = 0;
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        rec.sectionRamp[s] = sectionRamp[s];
+        rec.queueCount[s] = queueCount[s];
+        for (int k = 0; k < RAMP_QUEUE_SIZE; k++) {
+            const RampStep &step = rampQueue[s][(queueHead[s] + k) % RAMP_QUEUE_SIZE];
+            rec.queueTemp[s][k] = k < queueCount[s] ? step.temp : 0;
+            rec.queueHoldMs[s][k] = k < queueCount[s] ? step.holdMs : 0;
+        }
+        if (holding[s]) rec.holdingMask |= (1U << s);
+        rec.holdLeftMs[s] = holding[s] && (long)(holdUntil[s] - now) > 0 ? holdUntil[s] - now : 0;
+        rec.currentHoldMs[s] = currentHoldMs[s];
+    }
+}
+
+void restoreRamps(const RampRecord &rec) {
+    unsigned long now = millis();
+    rampEnabled = rec.enabled;
+    if (rec.maxRate > 0) rampMaxRate = rec.maxRate;
+    if (rec.powerBudget > 0) bedPowerBudget = rec.powerBudget;
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        sectionRamp[s] = rec.sectionRamp[s];
+        lastRate[s] = 0;
+        queueHead[s] = 0;
+        queueCount[s] = min(rec.queueCount[s], (uint8_t)RAMP_QUEUE_SIZE);
+        for (int k = 0; k < queueCount[s]; k++) {
+            rampQueue[s][k].temp = rec.queueTemp[s][k];
+            rampQueue[s][k].holdMs = rec.queueHoldMs[s][k];
+        }
+        holding[s] = rec.holdingMask & (1U << s);
+        holdUntil[s] = now + rec.holdLeftMs[s];
+        currentHoldMs[s] = rec.currentHoldMs[s];
+    }
+}
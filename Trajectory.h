@@ -0,0 +1,44 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <Arduino.h>
+
+// Gerador de trajetórias de setpoint: rampas por secção limitadas pela
+// potência total da mesa, entre targetTemp e os controladores
+
+#define RAMP_QUEUE_SIZE 4     // Queued setpoint changes per section
+#define RAMP_BLEND_S 30.0     // Ease-in time constant near the target (s)
+#define RAMP_SNAP 0.2         // °C: closer than this the ramp ends on the target
+#define RAMP_MAX_LEAD 10.0    // °C the ramp may run ahead of the section's temperature
+#define RAMP_SETTLE_BAND 2.0  // °C: a queued step's hold starts once this close
+
+extern bool rampEnabled;
+extern float rampMaxRate;      // °C/s slew limit
+extern float bedPowerBudget;   // W available for the whole bed
+extern float sectionRamp[4];   // Setpoint actually given to each section
+
+// Ramp state as STATE DUMP stores it: queues from their head, hold times as time left
+struct RampRecord {
+    uint8_t enabled;
+    float maxRate;
+    float powerBudget;
+    float sectionRamp[4];
+    float queueTemp[4][RAMP_QUEUE_SIZE];
+    uint32_t queueHoldMs[4][RAMP_QUEUE_SIZE];
+    uint8_t queueCount[4];
+    uint8_t holdingMask;
+    uint32_t holdLeftMs[4];
+    uint32_t currentHoldMs[4];
+};
+
+// Funções de trajetória
+void updateTrajectories();
+bool rampQueueReady();
+bool queueRamp(int section, float temp, unsigned long holdSeconds);
+void clearRampQueue(int section);
+void setRampEnabled(bool enabled);
+void printTrajectories();
+void saveRamps(RampRecord &rec);
+void restoreRamps(const RampRecord &rec);
+
+#endif
@@ -1,6 +1,9 @@
 #include "tempControl.h"
 #include "MY-HeatBed_Controller.h"
 #include "SerialCommands.h" // To access global variables
+#include "ControlStrategy.h"
+#include "Calibration.h"
+#include "Safety.h"
 
 // Declare variables that were removed from MY-HeatBed_Controller.ino
 float targetTemp[4] = {0, 0, 0, 0};
@@ -8,7 +11,7 @@ bool activeSegments[16] = {false}; // Initially, all segments are inactive
 
 float cachedTemperatures[16] = {0};
 unsigned long lastReadTime[16] = {0};
-const unsigned long readInterval = 1000;
+const unsigned long readInterval = 500; // Fastest segment control period (SCHEDULE_MINOR_MS)
 
 #include <Arduino.h>
 #include <avr/pgmspace.h>
@@ -50,15 +53,34 @@ float readTemperature(int sensorPin) {
         return cachedTemperatures[sensorIndex]; // Return cached value
     }
 
+    return sampleTemperature(sensorIndex);
+}
+
+// Fresh reading of one sensor, bypassing readInterval; updates the cache
+float sampleTemperature(int sensorIndex) {
     // Update the last read timestamp
     lastReadTime[sensorIndex] = millis();
 
-    // Perform analog reading
-    int analogValue = analogRead(sensorPin);
+    // Perform analog reading (through the fault injection hook)
+    int analogValue = injectedAdc(sensorIndex, analogRead(tempSensors[sensorIndex]));
 
+    float temperature = thermistorTemperature(analogValue);
+    if (temperature == -999.0) {
+        cachedTemperatures[sensorIndex] = -999.0; // Update cache with error
+        return -999.0;
+    }
+    temperature = injectedTemperature(sensorIndex, temperature);
+
+    // Update cache with new reading
+    cachedTemperatures[sensorIndex] = temperature;
+
+    return temperature;
+}
+
+// ADC count -> °C through the thermistor table, -999 when out of range
+float thermistorTemperature(int analogValue) {
     // Protection against out-of-range readings
     if (analogValue <= 0 || analogValue >= 1023) {
-        cachedTemperatures[sensorIndex] = -999.0; // Update cache with error
         return -999.0;
     }
 
@@ -74,22 +96,26 @@ float readTemperature(int sensorPin) {
     float adcLow = pgm_read_word(&tempTable[i - 1][0]);
     float tempLow = pgm_read_word(&tempTable[i - 1][1]);
 
-    float temperature = tempLow + (analogValue - adcLow) * (tempHigh - tempLow) / (adcHigh - adcLow);
-
-    // Update cache with new reading
-    cachedTemperatures[sensorIndex] = temperature;
-
-    return temperature;
+    return tempLow + (analogValue - adcLow) * (tempHigh - tempLow) / (adcHigh - adcLow);
 }
 
-float readTargetTemperature(int pwmPin) {
+// Setpoint from the Duet's PWM input, -999 when there is no usable signal.
+// The caller reports a lost signal once and fails safe.
+float readTargetTemperature(int secIndex) {
+    int pwmPin = pwmInPins[secIndex];
+
+    // Calibrated: duty measured on the pin -> fitted setpoint. A steady
+    // level (0% or 100%, no edges) is duty 0 or 1, as in the CAL IN fit.
+    if (pwmCalibrated) {
+        unsigned long highUs, periodUs;
+        float duty = measurePwmDuty(pwmPin, highUs, periodUs);
+        return pwmInMap[secIndex].slope * duty + pwmInMap[secIndex].offset;
+    }
+
     int pwmValue = pulseIn(pwmPin, HIGH, PWM_TIMEOUT); // Wait for timeout
 
     // Validate PWM signal
     if (pwmValue < pwmMinValue || pwmValue > pwmMaxValue) {
-        Serial.print("Error: PWM signal out of valid range (");
-        Serial.print(pwmValue);
-        Serial.println(").");
         return -999.0; // Return error
     }
 
@@ -125,171 +151,114 @@ void updateTemperaturePWM(int secIndex, int start, int end) {
     // Average of active segments, if any
     if (countActive > 0) {
         avgTemp = sumActive / countActive;
-        Serial.print("Sec ");
+        Serial.print(F("Sec "));
         Serial.print(secIndex + 1);
-        Serial.print(" (active): ");
+        Serial.print(F(" (active): "));
         Serial.print(avgTemp);
-        Serial.println("°C");
+        Serial.println(F("°C"));
     }
     // Average of all sensors if none active
     else if (countAll > 0) {
         avgTemp = sumAll / countAll;
-        Serial.print("Sec ");
+        Serial.print(F("Sec "));
         Serial.print(secIndex + 1);
-        Serial.print(" (none active): ");
+        Serial.print(F(" (none active): "));
         Serial.print(avgTemp);
-        Serial.println("°C");
+        Serial.println(F("°C"));
     }
     // No valid sensor found, send default safe value (25°C)
     else {
         avgTemp = 25.0;  // Default safe value
-        Serial.print("Sec ");
+        Serial.print(F("Sec "));
         Serial.print(secIndex + 1);
-        Serial.println(": No valid sensor found. Sending default value (25°C).");
+        Serial.println(F(": No valid sensor found. Sending default value (25°C)."));
     }
 
-    // 🔥 Corrected: inverting the PWM scale to match Duet's expectation
-    int pwmValue = map(avgTemp, tempMin, tempMax, pwmMaxValue, pwmMinValue);
-    pwmValue = constrain(pwmValue, pwmMinValue, pwmMaxValue);
-
-    // Send correctly inverted PWM value to DueX5
-    analogWrite(pwmOutPins[secIndex], pwmValue);
-
-    Serial.print("Sec ");
-    Serial.print(secIndex + 1);
-    Serial.print(" Avg Temp Sent: ");
-    Serial.print(avgTemp);
-    Serial.print("°C -> PWM: ");
-    Serial.println(pwmValue);    
-}
-
-void controlHeating(int secIndex, int start, int end) {
-    float sum = 0;
-    int count = 0;
-
-    for (int i = start; i <= end; i++) {
-        if (activeSegments[i]) {
-            sum += readTemperature(tempSensors[i]);
-            count++;
-        }
+    int pwmValue;
+    if (pwmCalibrated) {
+        // Fitted map already includes the inversion the Duet expects
+        pwmValue = (int)(pwmOutMap.slope * avgTemp + pwmOutMap.offset + 0.5);
+        pwmValue = constrain(pwmValue, 0, 255);
+    } else {
+        // 🔥 Corrected: inverting the PWM scale to match Duet's expectation
+        pwmValue = map(avgTemp, tempMin, tempMax, pwmMaxValue, pwmMinValue);
+        pwmValue = constrain(pwmValue, pwmMinValue, pwmMaxValue);
     }
 
-    float avgTemp = (count > 0) ? (sum / count) : 0;
-    float target = targetTemp[secIndex];
-
-    // Simple ON/OFF control with hysteresis
-    bool heatingOn = (avgTemp < target - TEMP_HYSTERESIS);
-    bool heatingOff = (avgTemp > target + TEMP_HYSTERESIS);
-
-    for (int i = start; i <= end; i++) {
-        if (activeSegments[i]) {
-            if (heatingOn) {
-                digitalWrite(relayPins[i], LOW); // Turn on segment
-            } else if (heatingOff) {
-                digitalWrite(relayPins[i], HIGH); // Turn off segment
-            }
-        }
+    // Send correctly inverted PWM value to DueX5 (the calibration handshake owns the outputs)
+    if (!calibrationActive) {
+        analogWrite(pwmOutPins[secIndex], pwmValue);
     }
 
-    Serial.print("Sec ");
+    Serial.print(F("Sec "));
     Serial.print(secIndex + 1);
-    Serial.print(" Current Temp: ");
+    Serial.print(F(" Avg Temp Sent: "));
     Serial.print(avgTemp);
-    Serial.print("°C | Setpoint: ");
-    Serial.print(target);
-    Serial.println("°C");
-}
-
-void checkThermalSafety() {
-    for (int i = 0; i < 16; i++) {
-        float temp = readTemperature(tempSensors[i]);
-        if (temp > MAX_SAFE_TEMPERATURE) {
-            thermalSafetyTriggered = true;
-            deactivateAllSegments(); // Deactivate all segments
-            Serial.print("ALERT: Critical temperature detected in segment ");
-            Serial.print(i + 1);
-            Serial.print(" (");
-            Serial.print(temp);
-            Serial.println("°C). All segments deactivated!");
-            break;
-        }
-    }
+    Serial.print(F("°C -> PWM: "));
+    Serial.println(pwmValue);    
 }
 
-float calculatePID(int segmentIndex, float currentTemp, float targetTemp) {
+// PID step on caller-owned state, so other controller instances (e.g. the
+// shadow controller) run exactly the same law with their own gains.
+// Returns the unclamped output, for callers that add terms before clamping.
+float computePIDRaw(float kp, float ki, float kd, float &integralState, float &lastError,
+                    unsigned long &lastUpdate, float currentTemp, float targetTemp) {
     unsigned long now = millis();
-    float deltaTime = (now - pidLastUpdate[segmentIndex]) / 1000.0; // Time in seconds
-    pidLastUpdate[segmentIndex] = now;
+    float deltaTime = (now - lastUpdate) / 1000.0; // Time in seconds
+    lastUpdate = now;
 
     // Calculate error
     float error = targetTemp - currentTemp;
 
     // Calculate proportional term
-    float proportional = pidKp * error;
+    float proportional = kp * error;
 
     // Calculate integral term
-    pidIntegral[segmentIndex] += error * deltaTime;
-    float integral = pidKi * pidIntegral[segmentIndex];
+    integralState += error * deltaTime;
+    float integral = ki * integralState;
 
-    // Calculate derivative term
-    float derivative = pidKd * (error - pidLastError[segmentIndex]) / deltaTime;
-    pidLastError[segmentIndex] = error;
+    // Calculate derivative term (skipped if no time has elapsed)
+    float derivative = (deltaTime > 0) ? kd * (error - lastError) / deltaTime : 0;
+    lastError = error;
 
     // Sum terms to get PID output
-    float output = proportional + integral + derivative;
+    return proportional + integral + derivative;
+}
+
+float computePID(float kp, float ki, float kd, float &integralState, float &lastError,
+                 unsigned long &lastUpdate, float currentTemp, float targetTemp) {
+    float output = computePIDRaw(kp, ki, kd, integralState, lastError, lastUpdate, currentTemp, targetTemp);
 
     // Limit output between 0 and 1 (for relay control)
     return constrain(output, 0.0, 1.0);
 }
 
-void controlHeatingWithPID(int secIndex, int start, int end) {
-    for (int i = start; i <= end; i++) {
-        if (activeSegments[i]) {
-            float currentTemp = readTemperature(tempSensors[i]);
-            float target = targetTemp[secIndex];
-
-            // Calculate PID output
-            float pidOutput = calculatePID(i, currentTemp, target);
-
-            // Turn relay on or off based on PID output
-            if (pidOutput > PID_OUTPUT_THRESHOLD) {
-                digitalWrite(relayPins[i], LOW); // Turn on segment
-            } else {
-                digitalWrite(relayPins[i], HIGH); // Turn off segment
-            }
-
-            // Print information to Serial
-            Serial.print("Segment ");
-            Serial.print(i + 1);
-            Serial.print(" | Current Temp: ");
-            Serial.print(currentTemp);
-            Serial.print("°C | Setpoint: ");
-            Serial.print(target);
-            Serial.print("°C | PID Output: ");
-            Serial.println(pidOutput);
-        }
-    }
+float calculatePID(int segmentIndex, float currentTemp, float targetTemp) {
+    return computePID(pidKp, pidKi, pidKd, pidIntegral[segmentIndex], pidLastError[segmentIndex],
+                      pidLastUpdate[segmentIndex], currentTemp, targetTemp);
 }
 
 void printSystemStatus() {
-    Serial.println("=== System Status ===");
-    Serial.println("Debug Mode: " + String(debugMode ? "Enabled" : "Disabled"));
-    Serial.println("Thermal Safety State: " + String(thermalSafetyTriggered ? "Triggered" : "Normal"));
+    Serial.println(F("=== System Status ==="));
+    Serial.print(F("Debug Mode: "));
+    Serial.println(debugMode ? F("Enabled") : F("Disabled"));
+    Serial.print(F("Thermal Safety State: "));
+    Serial.println(thermalSafetyTriggered ? F("Triggered") : F("Normal"));
     for (int i = 0; i < 16; i++) {
-        Serial.print("Segment ");
+        Serial.print(F("Segment "));
         Serial.print(i + 1);
-        Serial.print(": ");
-        Serial.print(activeSegments[i] ? "Active" : "Inactive");
-        Serial.print(" | Temp: ");
+        Serial.print(F(": "));
+        Serial.print(activeSegments[i] ? F("Active") : F("Inactive"));
+        Serial.print(F(" | Temp: "));
         Serial.print(readTemperature(tempSensors[i])); // Ensure readTemperature and tempSensors are declared
-        Serial.println("°C");
+        Serial.println(F("°C"));
     }
     for (int i = 0; i < 4; i++) {
-        Serial.print("Sec ");
+        Serial.print(F("Sec "));
         Serial.print(i + 1);
-        Serial.print(" | Setpoint: ");
+        Serial.print(F(" | Setpoint: "));
         Serial.print(targetTemp[i]);
-        Serial.println("°C");
+        Serial.println(F("°C"));
     }
-    Serial.println("=====================");
+    Serial.println(F("====================="));
 }
@@ -14,10 +14,10 @@ extern const unsigned long readInterval;
 
 // Function Prototypes
 float readTemperature(int sensorPin);
+float sampleTemperature(int sensorIndex);
+float thermistorTemperature(int analogValue);
 void updateTemperaturePWM(int section, int startSegment, int endSegment);
-void controlHeating(int secIndex, int start, int end);
 void checkThermalSafety();
-void controlHeatingWithPID(int secIndex, int start, int end);
 void printSystemStatus(); // Declare the function here
 
 #endif // TEMP_CONTROL_H
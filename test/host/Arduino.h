@@ -0,0 +1,121 @@
+// Minimal host stand-in for the Arduino core, enough to build the sketch
+// on a PC for the tests in this directory. See sim.cpp for the runtime.
+#pragma once
+#define F_CPU 16000000UL
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <avr/pgmspace.h>
+typedef uint8_t byte;
+typedef bool boolean;
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define LED_BUILTIN 13
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A4 58
+#define A5 59
+#define A6 60
+#define A7 61
+#define A8 62
+#define A9 63
+#define A10 64
+#define A11 65
+#define A12 66
+#define A13 67
+#define A14 68
+#define A15 69
+#define DEC 10
+#define HEX 16
+#define BIN 2
+class __FlashStringHelper;
+#define F(x) (reinterpret_cast<const __FlashStringHelper *>(x))
+#define constrain(a,l,h) ((a)<(l)?(l):((a)>(h)?(h):(a)))
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define abs(x) ((x)>0?(x):-(x))
+#define sq(x) ((x)*(x))
+#define bitRead(v,b) (((v)>>(b))&1)
+#define bitSet(v,b) ((v)|=(1UL<<(b)))
+#define bitClear(v,b) ((v)&=~(1UL<<(b)))
+#define lowByte(w) ((uint8_t)((w)&0xff))
+#define highByte(w) ((uint8_t)((w)>>8))
+#define noInterrupts()
+#define interrupts()
+#define cli()
+#define sei()
+long map(long,long,long,long,long);
+unsigned long millis(); unsigned long micros();
+void delay(unsigned long); void delayMicroseconds(unsigned int);
+int analogRead(uint8_t); void analogWrite(uint8_t,int);
+void digitalWrite(uint8_t,uint8_t); int digitalRead(uint8_t); void pinMode(uint8_t,uint8_t);
+unsigned long pulseIn(uint8_t,uint8_t,unsigned long t=1000000L);
+inline bool isDigit(int c){return c>='0'&&c<='9';}
+class String {
+public:
+  std::string s;
+  String(){} String(const char*c):s(c?c:""){} String(const std::string&x):s(x){}
+  String(char c):s(1,c){}
+  String(int v,unsigned char b=10){char t[34];snprintf(t,34,b==16?"%x":"%d",v);s=t;}
+  String(unsigned int v,unsigned char b=10){char t[34];snprintf(t,34,b==16?"%x":"%u",v);s=t;}
+  String(long v,unsigned char b=10){char t[34];snprintf(t,34,b==16?"%lx":"%ld",v);s=t;}
+  String(unsigned long v,unsigned char b=10){char t[34];snprintf(t,34,b==16?"%lx":"%lu",v);s=t;}
+  String(float v,unsigned char d=2){char t[34];snprintf(t,34,"%.*f",d,v);s=t;}
+  String(double v,unsigned char d=2){char t[34];snprintf(t,34,"%.*f",d,v);s=t;}
+  unsigned int length()const{return s.size();}
+  bool operator==(const char*c)const{return s==c;} bool operator==(const String&o)const{return s==o.s;}
+  bool operator!=(const char*c)const{return s!=c;}
+  String operator+(const String&o)const{return String(s+o.s);}
+  String operator+(const char*o)const{return String(s+o);}
+  friend String operator+(const char*a,const String&b){return String(std::string(a)+b.s);}
+  String& operator+=(const String&o){s+=o.s;return *this;}
+  String& operator+=(const char*o){s+=o;return *this;}
+  String& operator+=(char o){s+=o;return *this;}
+  bool concat(const String&o){s+=o.s;return true;}
+  bool startsWith(const String&p)const{return s.rfind(p.s,0)==0;}
+  bool startsWith(const char*p)const{return s.rfind(p,0)==0;}
+  bool endsWith(const char*p)const{size_t n=strlen(p);return s.size()>=n&&s.compare(s.size()-n,n,p)==0;}
+  String substring(unsigned a)const{return a>=s.size()?String():String(s.substr(a));}
+  String substring(unsigned a,unsigned b)const{if(a>b)std::swap(a,b);if(a>=s.size())return String();return String(s.substr(a,b-a));}
+  int indexOf(char c,unsigned f=0)const{auto p=s.find(c,f);return p==std::string::npos?-1:(int)p;}
+  int indexOf(const char*c,unsigned f=0)const{auto p=s.find(c,f);return p==std::string::npos?-1:(int)p;}
+  int indexOf(const String&c,unsigned f=0)const{auto p=s.find(c.s,f);return p==std::string::npos?-1:(int)p;}
+  int lastIndexOf(char c)const{auto p=s.rfind(c);return p==std::string::npos?-1:(int)p;}
+  int lastIndexOf(const char*c)const{auto p=s.rfind(c);return p==std::string::npos?-1:(int)p;}
+  int lastIndexOf(const char*c,unsigned f)const{auto p=s.rfind(c,f);return p==std::string::npos?-1:(int)p;}
+  int lastIndexOf(char c,unsigned f)const{auto p=s.rfind(c,f);return p==std::string::npos?-1:(int)p;}
+  long toInt()const{return atol(s.c_str());} float toFloat()const{return atof(s.c_str());}
+  void reserve(unsigned n){s.reserve(n);}
+  void trim(){size_t a=s.find_first_not_of(" \t\r\n");if(a==std::string::npos){s.clear();return;}size_t b=s.find_last_not_of(" \t\r\n");s=s.substr(a,b-a+1);}
+  void toLowerCase(){for(auto&c:s)c=tolower(c);}
+  void toCharArray(char*b,unsigned n)const{if(!n)return;size_t k=s.size()<(size_t)n-1?s.size():(size_t)n-1;memcpy(b,s.data(),k);b[k]=0;}
+  void toUpperCase(){for(auto&c:s)c=toupper(c);}
+  char charAt(unsigned i)const{return i<s.size()?s[i]:0;}
+  char operator[](unsigned i)const{return charAt(i);}
+  const char*c_str()const{return s.c_str();}
+};
+class Print { public:
+  size_t write(uint8_t);size_t write(const uint8_t*,size_t);
+  size_t print(const String&);size_t print(const char*);size_t print(char);
+  size_t print(const __FlashStringHelper *f){return print(reinterpret_cast<const char*>(f));}
+  size_t println(const __FlashStringHelper *f){return println(reinterpret_cast<const char*>(f));}
+  size_t print(int,int=DEC);size_t print(unsigned int,int=DEC);size_t print(long,int=DEC);size_t print(unsigned long,int=DEC);size_t print(double,int=2);
+  size_t println(const String&);size_t println(const char*);size_t println(char);
+  size_t println(int,int=DEC);size_t println(unsigned int,int=DEC);size_t println(long,int=DEC);size_t println(unsigned long,int=DEC);size_t println(double,int=2);size_t println();
+};
+class Stream : public Print { public: int available();int read();int peek();void flush();String readStringUntil(char);size_t readBytes(uint8_t*,size_t);void setTimeout(unsigned long);};
+class HardwareSerial : public Stream { public: void begin(unsigned long); void end(); operator bool(){return true;} };
+extern HardwareSerial Serial, Serial1, Serial2, Serial3;
@@ -0,0 +1,6 @@
+#pragma once
+// Host EEPROM: 4 KB in RAM, erased to 0xFF (see sim.cpp)
+#include <Arduino.h>
+struct EEPROMClass { uint8_t read(int); void write(int,uint8_t); void update(int,uint8_t); uint16_t length();
+ template<typename T> T& get(int a, T& t){uint8_t*p=(uint8_t*)&t;for(unsigned i=0;i<sizeof(T);i++)p[i]=read(a+i);return t;} template<typename T> const T& put(int a,const T&t){const uint8_t*p=(const uint8_t*)&t;for(unsigned i=0;i<sizeof(T);i++)update(a+i,p[i]);return t;} };
+extern EEPROMClass EEPROM;
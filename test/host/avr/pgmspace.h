@@ -0,0 +1,8 @@
+#pragma once
+// On the host, PROGMEM data is ordinary memory
+#define PROGMEM
+#define pgm_read_word(a) (*(a))
+#define pgm_read_byte(a) (*(a))
+#define pgm_read_float(a) (*(a))
+#define pgm_read_dword(a) (*(a))
+#define strcmp_P(a, b) strcmp((a), (b))
@@ -0,0 +1,44 @@
+// Host runtime for the sketch: a clock, ADC inputs and pin outputs the tests
+// control directly. Lines queued in in0 (USB) / in1 (Duet) are read by
+// readStringUntil(); output goes to stdout unless simQuiet is set.
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <cstdio>
+#include <deque>
+#include <map>
+HardwareSerial Serial, Serial1, Serial2, Serial3; EEPROMClass EEPROM;
+static uint8_t eep[4096]; static bool eepInit=false;
+static void ei(){ if(!eepInit){memset(eep,0xff,sizeof eep);eepInit=true;} }
+uint8_t EEPROMClass::read(int a){ei();return eep[a];} void EEPROMClass::write(int a,uint8_t v){ei();eep[a]=v;} void EEPROMClass::update(int a,uint8_t v){ei();eep[a]=v;} uint16_t EEPROMClass::length(){return 4096;}
+unsigned long simMs=0; int simAdc[70]; int simPin[70];
+std::deque<std::string> in0, in1;
+long map(long x,long a,long b,long c,long d){return (x-a)*(d-c)/(b-a)+c;}
+unsigned long millis(){return simMs;} unsigned long micros(){return simMs*1000;} void delay(unsigned long d){simMs+=d;} void delayMicroseconds(unsigned int){}
+int analogRead(uint8_t p){return simAdc[p];} void analogWrite(uint8_t,int){} void digitalWrite(uint8_t p,uint8_t v){simPin[p]=v;} int digitalRead(uint8_t p){return simPin[p];} void pinMode(uint8_t,uint8_t){}
+unsigned long pulseIn(uint8_t,uint8_t,unsigned long){return 0;}
+extern bool simQuiet; bool simQuiet=false;
+std::string simOutput; // Everything printed, quiet or not
+static size_t out(const std::string&s);
+size_t Print::write(uint8_t c){return out(std::string(1,(char)c));} size_t Print::write(const uint8_t*b,size_t n){return out(std::string((const char*)b,n));}
+static size_t out(const std::string&s){ simOutput+=s; if(simOutput.size()>65536) simOutput.erase(0,32768); if(!simQuiet) fputs(s.c_str(),stdout); return s.size();}
+size_t Print::print(const String&s){return out(s.s);} size_t Print::print(const char*s){return out(s);} size_t Print::print(char c){return out(std::string(1,c));}
+size_t Print::println(const String&s){return out(s.s+"\n");} size_t Print::println(const char*s){return out(std::string(s)+"\n");} size_t Print::println(char c){return out(std::string(1,c)+"\n");}
+static std::string num(long v,int b){char t[40];if(b==16)snprintf(t,40,"%lX",v);else snprintf(t,40,"%ld",v);return t;}
+static std::string unum(unsigned long v,int b){char t[40];if(b==16)snprintf(t,40,"%lX",v);else snprintf(t,40,"%lu",v);return t;}
+size_t Print::print(int v,int b){return out(num(v,b));} size_t Print::println(int v,int b){return out(num(v,b)+"\n");}
+size_t Print::print(unsigned int v,int b){return out(unum(v,b));} size_t Print::println(unsigned int v,int b){return out(unum(v,b)+"\n");}
+size_t Print::print(long v,int b){return out(num(v,b));} size_t Print::println(long v,int b){return out(num(v,b)+"\n");}
+size_t Print::print(unsigned long v,int b){return out(unum(v,b));} size_t Print::println(unsigned long v,int b){return out(unum(v,b)+"\n");}
+size_t Print::print(double v,int d){char t[40];snprintf(t,40,"%.*f",d,v);return out(t);} size_t Print::println(double v,int d){char t[40];snprintf(t,40,"%.*f\n",d,v);return out(t);}
+size_t Print::println(){return out("\n");}
+// Queued lines become a character stream, one line (plus '\n') at a time
+static std::string pending0, pending1;
+static std::deque<std::string>& q(Stream*s){return s==&Serial1?in1:in0;}
+static std::string& pend(Stream*s){return s==&Serial1?pending1:pending0;}
+static bool fill(Stream*s){ std::string&p=pend(s); if(p.empty()&&!q(s).empty()){p=q(s).front()+"\n";q(s).pop_front();} return !p.empty();}
+int Stream::available(){return fill(this)?pend(this).size():0;}
+int Stream::read(){ if(!fill(this))return -1; int c=(uint8_t)pend(this)[0]; pend(this).erase(0,1); return c;}
+int Stream::peek(){ return fill(this)?(uint8_t)pend(this)[0]:-1;} void Stream::flush(){}
+String Stream::readStringUntil(char t){ std::string s; int c; while((c=read())>=0 && c!=t) s+=(char)c; return String(s);}
+size_t Stream::readBytes(uint8_t*b,size_t n){ size_t k=0; int c; while(k<n && (c=read())>=0) b[k++]=c; return k;} void Stream::setTimeout(unsigned long){}
+void HardwareSerial::begin(unsigned long){} void HardwareSerial::end(){}
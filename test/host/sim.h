@@ -0,0 +1,50 @@
+// Helpers shared by the host tests
+#pragma once
+#include <cstdio>
+#include <deque>
+#include <string>
+
+extern unsigned long simMs;
+extern int simAdc[70];
+extern int simPin[70];
+extern std::deque<std::string> in0, in1;
+extern bool simQuiet;
+extern std::string simOutput;
+
+void setup();
+void loop();
+
+static int simFailures = 0;
+
+// Loop passes, 10 ms apart
+static inline void simRun(unsigned long ms) {
+    unsigned long end = simMs + ms;
+    while (simMs < end) {
+        loop();
+        simMs += 10;
+    }
+}
+
+// One command on the USB port; its reply is printed, the rest is quiet
+static inline void simCommand(const char *line) {
+    in0.push_back(line);
+    simQuiet = false;
+    simRun(20);
+    simQuiet = true;
+}
+
+// Last line printed that starts with prefix, without the newline
+static inline std::string simLastLine(const char *prefix) {
+    size_t at = simOutput.rfind(std::string("\n") + prefix);
+    if (at == std::string::npos) return "";
+    size_t end = simOutput.find('\n', at + 1);
+    return simOutput.substr(at + 1, end == std::string::npos ? std::string::npos : end - at - 1);
+}
+
+#define EXPECT(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+            simFailures++; \
+        } \
+    } while (0)
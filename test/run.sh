@@ -0,0 +1,23 @@
+#!/bin/sh
+# Host tests: builds the sketch with the stubs in host/ and runs every
+# test_*.cpp against it. Usage: test/run.sh [test_name ...]
+set -e
+root=$(cd "$(dirname "$0")/.." && pwd)
+out=${TEST_BUILD_DIR:-/tmp/heatbed-test}
+rm -rf "$out"; mkdir -p "$out/sketch"
+
+cxx="g++ -std=gnu++11 -g -w -I$root/test/host"
+for f in "$root"/*.cpp "$root/MY-HeatBed_Controller.ino"; do
+    $cxx -x c++ -include Arduino.h -c "$f" -o "$out/sketch/$(basename "$f").o"
+done
+$cxx -c "$root/test/host/sim.cpp" -o "$out/sim.o"
+
+tests=$*
+[ -n "$tests" ] || tests=$(cd "$root/test" && ls test_*.cpp | sed 's/\.cpp$//')
+failed=0
+for t in $tests; do
+    $cxx -I"$root" -include Arduino.h -c "$root/test/$t.cpp" -o "$out/$t.o"
+    g++ "$out"/sketch/*.o "$out/sim.o" "$out/$t.o" -o "$out/$t"
+    if "$out/$t"; then echo "PASS $t"; else echo "FAIL $t"; failed=1; fi
+done
+exit $failed
@@ -0,0 +1,41 @@
+// Bounded command lines, and hex blobs decoded straight from the port
+// (user-110): STATE LOAD / CONFIG IMPORT work from both ports while any
+// other line longer than COMMAND_MAX_LEN is dropped whole.
+#include "sim.h"
+#include "SerialCommands.h"
+#include "MY-HeatBed_Controller.h"
+
+int main() {
+    simQuiet = true;
+    for (int i = 0; i < 70; i++) simAdc[i] = 700;
+    setup();
+    simRun(1000);
+
+    // Too long: rejected, and the next line is a command again
+    simCommand(std::string(COMMAND_MAX_LEN + 50, 'X').c_str());
+    EXPECT(simLastLine("Error: Command too long").size() > 0);
+    simCommand("SET_PID 3 0.2 1");
+    EXPECT(pidKp == 3.0);
+
+    // CONFIG round trip through the Duet port
+    simCommand("CONFIG EXPORT");
+    std::string blob = simLastLine("CONFIG ");
+    EXPECT(blob.size() > 2 * COMMAND_MAX_LEN);
+    simCommand("SET_PID 9 9 9");
+    in1.push_back("CONFIG IMPORT " + blob.substr(7));
+    simRun(100);
+    EXPECT(pidKp == 3.0);
+
+    // A short or corrupted blob changes nothing and leaves no stray command
+    simCommand("SET_PID 9 9 9");
+    simCommand(("CONFIG IMPORT " + blob.substr(7, 40)).c_str());
+    EXPECT(simLastLine("Error: Config blob").size() > 0);
+    std::string bad = blob.substr(7);
+    bad[10] = 'Z';
+    simCommand(("CONFIG IMPORT " + bad).c_str());
+    EXPECT(pidKp == 9.0);
+    simCommand("STATE LOAD");
+    EXPECT(simLastLine("Error: Usage STATE LOAD").size() > 0);
+
+    return simFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+// Randomised check of the safety latch invariants (user-109):
+//  - while latched, no relay output is driven on;
+//  - the latch only clears on RESET_SAFETY, and never with a sensor above
+//    SAFETY_TEMP_MAX.
+// Random commands on both ports, random sensor readings (some over the
+// limit) and random loop timing, from a fixed seed.
+#include <cstdlib>
+#include "sim.h"
+#include "Safety.h"
+#include "TemperatureControl.h"
+
+extern bool thermalSafetyTriggered;
+extern const int relayPins[16];
+
+static const char *commands[] = {
+    "ON ALL", "OFF ALL", "ON 3", "OFF 3", "RESET_SAFETY", "SET_TEMP 1 100", "SET_TEMP 2 60",
+    "STRATEGY 1 MANUAL 80", "STRATEGY 1 PID", "STRATEGY 3 HYST", "FAULT OVERTEMP 4 130",
+    "FAULT CLEAR", "FAULT OPEN 2", "POWER CAP 300", "POWER CAP 0", "garbage!!"
+};
+static const int commandCount = sizeof(commands) / sizeof(commands[0]);
+
+// As the firmware sees the sensors, through the fault injection hook
+// (an injected open thermistor hides the real reading)
+static bool anySensorHot() {
+    for (int i = 0; i < 16; i++) {
+        float temp = thermistorTemperature(injectedAdc(i, simAdc[A0 + i]));
+        if (temp != -999.0 && injectedTemperature(i, temp) > SAFETY_TEMP_MAX) return true;
+    }
+    return false;
+}
+
+int main() {
+    srand(42);
+    simQuiet = true;
+    for (int i = 0; i < 70; i++) simAdc[i] = 700;
+    setup();
+
+    long latchedSteps = 0, resets = 0;
+    for (long step = 0; step < 200000; step++) {
+        int r = rand() % 100;
+        std::string sent;
+        if (r < 3) {
+            sent = commands[rand() % commandCount];
+            if (rand() % 2) in0.push_back(sent); else in1.push_back(sent);
+        } else if (r < 6) {
+            simAdc[A0 + rand() % 16] = (rand() % 10 == 0) ? 100 + rand() % 100 : 500 + rand() % 500;
+        }
+
+        bool before = thermalSafetyTriggered;
+        loop();
+        simMs += 1 + rand() % 50;
+
+        if (thermalSafetyTriggered) {
+            latchedSteps++;
+            for (int i = 0; i < 16; i++) {
+                EXPECT(simPin[relayPins[i]] == HIGH); // Active LOW: HIGH is off
+            }
+        }
+        if (before && !thermalSafetyTriggered) {
+            resets++;
+            EXPECT(sent == "RESET_SAFETY");
+            EXPECT(!anySensorHot());
+        }
+        if (simFailures > 20) break;
+    }
+    printf("latched steps=%ld resets=%ld failures=%d\n", latchedSteps, resets, simFailures);
+    return (simFailures == 0 && latchedSteps > 0 && resets > 0) ? 0 : 1;
+}
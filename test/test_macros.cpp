@@ -0,0 +1,65 @@
+// The macro table is walked by findMacro, listMacros and deleteMacro; they
+// must agree on the entry size (user-119), so every entry after the first
+// can be run, shown, deleted and redefined.
+#include "sim.h"
+#include "MY-HeatBed_Controller.h"
+
+static int countOf(const std::string &text, const std::string &needle) {
+    int n = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) n++;
+    return n;
+}
+
+// Output of one command
+static std::string reply(const char *line) {
+    size_t start = simOutput.size();
+    simCommand(line);
+    return simOutput.substr(start);
+}
+
+int main() {
+    simQuiet = true;
+    for (int i = 0; i < 70; i++) simAdc[i] = 700;
+    setup();
+    simRun(1000);
+
+    simCommand("MACRO CLEAR");
+    simCommand("MACRO DEFINE FIRST ON 1");
+    simCommand("MACRO DEFINE SECOND ON 2;SET_TEMP 1 50");
+    simCommand("MACRO DEFINE THIRD SET_TEMP 2 $1;WAIT 100");
+    std::string list = reply("MACRO LIST");
+    EXPECT(list.find("FIRST") != std::string::npos);
+    EXPECT(list.find("SECOND") != std::string::npos);
+    EXPECT(list.find("THIRD") != std::string::npos);
+    EXPECT(list.find("CORRUPTED") == std::string::npos);
+
+    // The last entry is found: RUN, SHOW
+    simCommand("RUN THIRD 85");
+    simRun(200);
+    EXPECT(targetTemp[1] == 85);
+    std::string shown = reply("MACRO SHOW THIRD");
+    EXPECT(shown.find("SET_TEMP 2 $1") != std::string::npos);
+    EXPECT(shown.find("WAIT 100") != std::string::npos);
+    EXPECT(reply("MACRO SHOW SECOND").find("SET_TEMP 1 50") != std::string::npos);
+
+    // Redefining a later entry replaces it instead of adding a second copy
+    simCommand("MACRO DEFINE SECOND ON 3");
+    list = reply("MACRO LIST");
+    EXPECT(countOf(list, "SECOND") == 1);
+    EXPECT(reply("MACRO SHOW SECOND").find("ON 3") != std::string::npos);
+
+    // Deleting the last entry leaves the others intact
+    EXPECT(reply("MACRO DELETE THIRD").find("Macro deleted.") != std::string::npos);
+    EXPECT(reply("MACRO SHOW THIRD").find("Error: Unknown macro.") != std::string::npos);
+    list = reply("MACRO LIST");
+    EXPECT(list.find("THIRD") == std::string::npos);
+    EXPECT(list.find("FIRST") != std::string::npos);
+    EXPECT(list.find("SECOND") != std::string::npos);
+    EXPECT(list.find("CORRUPTED") == std::string::npos);
+
+    simCommand("RUN FIRST");
+    simRun(100);
+    EXPECT(activeSegments[0]);
+
+    return simFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+// Heating one section while the rest stay idle must not latch a runaway
+// (user-108): conduction from the hot section is explained by the
+// neighbours. A segment that heats above all its neighbours with duty 0
+// still latches.
+#include "sim.h"
+#include "MY-HeatBed_Controller.h"
+#include "Safety.h"
+#include "TemperatureControl.h"
+
+extern bool thermalSafetyTriggered;
+
+// Raw reading that the thermistor table turns into the closest temperature
+static int adcFor(float temp) {
+    int best = 0;
+    float bestError = 1e9;
+    for (int adc = 0; adc < 1024; adc++) {
+        float t = thermistorTemperature(adc);
+        if (t == -999.0) continue;
+        if (fabs(t - temp) < bestError) {
+            bestError = fabs(t - temp);
+            best = adc;
+        }
+    }
+    return best;
+}
+
+static void setRow(int row, float temp) {
+    for (int c = 0; c < 4; c++) simAdc[A0 + row * 4 + c] = adcFor(temp);
+}
+
+int main() {
+    simQuiet = true;
+    for (int i = 0; i < 16; i++) simAdc[A0 + i] = adcFor(25);
+    setup();
+    simRun(1000);
+
+    // Section 1 (first row) heats to 100 °C; the next rows follow by
+    // conduction, each cooler than the one before, with duty 0
+    for (int i = 1; i <= 4; i++) {
+        char line[8];
+        snprintf(line, sizeof(line), "ON %d", i);
+        simCommand(line);
+    }
+    simCommand("SET_TEMP 1 100");
+    for (int minute = 0; minute <= 10; minute++) {
+        float f = minute / 10.0;
+        setRow(0, 25 + 75 * f);
+        setRow(1, 25 + 55 * f);
+        setRow(2, 25 + 30 * f);
+        setRow(3, 25 + 15 * f);
+        simRun(60000);
+        EXPECT(!thermalSafetyTriggered);
+    }
+
+    // A lower setpoint next to hot neighbours trips no more than setpoint 0
+    simCommand("ON 5");
+    simCommand("SETPOINTS 100,100,100,100,40,0,0,0,0,0,0,0,0,0,0,0");
+    simRun(60000);
+    EXPECT(!thermalSafetyTriggered);
+
+    // A segment hotter than every neighbour (55 and 40 °C) and still
+    // rising, with duty 0
+    simCommand("OFF 5");
+    for (int step = 0; step <= 20; step++) {
+        simAdc[A0 + 15] = adcFor(60 + step);
+        simRun(3000);
+    }
+    EXPECT(thermalSafetyTriggered);
+
+    return simFailures == 0 ? 0 : 1;
+}
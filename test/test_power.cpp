@@ -0,0 +1,81 @@
+// Deactivating a segment clears its duty (user-120), so OFF then ON does not
+// drive the relay at the old duty before the next control tick, the power
+// cap still bounds what the relays draw, and the stagger holds for a window.
+#include "sim.h"
+#include "MY-HeatBed_Controller.h"
+#include "ControlStrategy.h"
+#include "Energy.h"
+#include "Pins.h"
+#include "Power.h"
+
+int main() {
+    simQuiet = true;
+    for (int i = 0; i < 70; i++) simAdc[i] = 700;
+    setup();
+    simRun(1000);
+
+    simCommand("ON ALL");
+    simCommand("SET_TEMP 1 110");
+    simRun(2 * CONTROL_INTERVAL);
+    EXPECT(requestedDuty[0] > 0);
+    EXPECT(segmentDuty[0] > 0);
+
+    // OFF clears the duty; ON right after it leaves the relay off
+    simCommand("OFF 1");
+    EXPECT(requestedDuty[0] == 0);
+    EXPECT(segmentDuty[0] == 0);
+    EXPECT(simPin[relayPins[0]] == HIGH);
+    activateSegment(1);
+    bool driven = false;
+    for (int pass = 0; pass < 100; pass++) { // One relay window, no control tick
+        simMs += 10;
+        updateRelayOutputs();
+        driven |= simPin[relayPins[0]] == LOW;
+    }
+    EXPECT(!driven);
+    EXPECT(segmentDuty[0] == 0);
+
+    // OFF ALL goes through the same path
+    simRun(2 * CONTROL_INTERVAL);
+    EXPECT(requestedDuty[0] > 0);
+    simCommand("OFF ALL");
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        EXPECT(requestedDuty[i] == 0);
+        EXPECT(segmentDuty[i] == 0);
+        EXPECT(simPin[relayPins[i]] == HIGH);
+    }
+
+    // A cap below the request scales every applied duty down to it
+    simCommand("ON ALL");
+    simCommand("SET_TEMP 2 110");
+    simRun(2 * CONTROL_INTERVAL);
+    float cap = requestedPower() / 2;
+    EXPECT(cap > 0);
+    powerCapWatts = cap;
+    updateRelayOutputs();
+    EXPECT(appliedPower() <= cap + 0.5);
+    powerCapWatts = 0;
+
+    // The stagger is latched per window: raising an earlier segment's duty
+    // mid-window does not move a later segment's on-time (no extra click)
+    simCommand("OFF ALL");
+    activateSegment(1);
+    activateSegment(2);
+    simMs = (simMs / RELAY_WINDOW_MS + 1) * RELAY_WINDOW_MS;
+    requestedDuty[0] = 0.3;
+    requestedDuty[1] = 0.3;
+    unsigned long clicks = relaySwitches[1];
+    bool gap = false;
+    for (int pass = 0; pass < 100; pass++) {
+        unsigned long phase = simMs % RELAY_WINDOW_MS;
+        if (phase == RELAY_WINDOW_MS * 4 / 10) requestedDuty[0] = 0.5;
+        updateRelayOutputs();
+        bool inOnTime = phase >= RELAY_WINDOW_MS * 3 / 10 + 10 && phase < RELAY_WINDOW_MS * 6 / 10 - 10;
+        gap |= inOnTime && simPin[relayPins[1]] == HIGH;
+        simMs += RELAY_WINDOW_MS / 100;
+    }
+    EXPECT(!gap);
+    EXPECT(relaySwitches[1] == clicks + 1);
+
+    return simFailures == 0 ? 0 : 1;
+}
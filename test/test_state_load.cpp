@@ -0,0 +1,51 @@
+// STATE LOAD must not bypass the safety latch (user-110): refused while
+// latched, a blob can only set the latch, and segments come on through the
+// same latch-checked path as ON.
+#include "sim.h"
+#include "Pins.h"
+
+extern bool thermalSafetyTriggered;
+
+static int activeCount() {
+    int n = 0;
+    for (int i = 0; i < 16; i++) n += activeSegments[i];
+    return n;
+}
+
+int main() {
+    simQuiet = true;
+    for (int i = 0; i < 70; i++) simAdc[i] = 700;
+    setup();
+    simRun(1000);
+
+    simCommand("ON ALL");
+    simCommand("STATE DUMP");
+    std::string running = simLastLine("STATE ");
+    EXPECT(running.size() > 100);
+
+    // Latched: an unlatched blob is refused and the relays stay off
+    simCommand("FAULT OVERTEMP 4 130");
+    simRun(500);
+    EXPECT(thermalSafetyTriggered);
+    simCommand("STATE DUMP");
+    std::string latched = simLastLine("STATE ");
+    simCommand("FAULT CLEAR");
+    in1.push_back("STATE LOAD " + running.substr(6)); // From the Duet port
+    simRun(100);
+    EXPECT(thermalSafetyTriggered);
+    EXPECT(activeCount() == 0);
+
+    // Unlatched: the running blob turns the segments back on
+    simCommand("RESET_SAFETY");
+    EXPECT(!thermalSafetyTriggered);
+    simCommand(("STATE LOAD " + running.substr(6)).c_str());
+    EXPECT(!thermalSafetyTriggered);
+    EXPECT(activeCount() == 16);
+
+    // A latched blob latches, with every segment off
+    simCommand(("STATE LOAD " + latched.substr(6)).c_str());
+    EXPECT(thermalSafetyTriggered);
+    EXPECT(activeCount() == 0);
+
+    return simFailures == 0 ? 0 : 1;
+}